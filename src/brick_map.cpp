@@ -0,0 +1,241 @@
+#include "brick_map.h"
+
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+/*****************************************************************************/
+namespace {
+template <typename T>
+void computeBrickRange(vtkImageData* image_data, const int* extent,
+                       double* min_value, double* max_value) {
+  vtkIdType increments[3];
+  image_data->GetIncrements(increments);
+  const T* base = static_cast<const T*>(
+      image_data->GetScalarPointer(extent[0], extent[2], extent[4]));
+
+  T lo = *base;
+  T hi = *base;
+  for (int k = 0; k <= extent[5] - extent[4]; ++k) {
+    for (int j = 0; j <= extent[3] - extent[2]; ++j) {
+      const T* row = base + k * increments[2] + j * increments[1];
+      for (int i = 0; i <= extent[1] - extent[0]; ++i) {
+        lo = std::min(lo, row[i]);
+        hi = std::max(hi, row[i]);
+      }
+    }
+  }
+  *min_value = static_cast<double>(lo);
+  *max_value = static_cast<double>(hi);
+}
+}  // namespace
+/*****************************************************************************/
+BrickMap::BrickMap(vtkImageData* image_data, int brick_size_) {
+  init(image_data, brick_size_);
+  vtkSMPTools::For(0, getNumberOfBricks(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType brick = begin; brick != end; ++brick) {
+      computeRange(image_data, static_cast<int>(brick));
+    }
+  });
+}
+/*****************************************************************************/
+BrickMap::BrickMap(vtkImageData* image_data, const BrickMap& source,
+                   int reach) {
+  init(image_data, source.brick_size);
+  if (!std::equal(image_extent, image_extent + 6, source.image_extent)) {
+    throw std::runtime_error("BrickMap source has a different extent");
+  }
+  // Блок может задеть ядро, которое достаёт из блоков на reach вокселей
+  // дальше, плюс перекрытие блоков на один воксель
+  int brick_reach = (reach + brick_size - 1) / brick_size + 1;
+  vtkSMPTools::For(0, getNumberOfBricks(), [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType brick = begin; brick != end; ++brick) {
+      int index[3] = {static_cast<int>(brick % bricks[0]),
+                      static_cast<int>(brick / bricks[0] % bricks[1]),
+                      static_cast<int>(brick / (bricks[0] * bricks[1]))};
+      int lower[3];
+      int upper[3];
+      for (int axis = 0; axis != 3; ++axis) {
+        lower[axis] = std::max(index[axis] - brick_reach, 0);
+        upper[axis] = std::min(index[axis] + brick_reach, bricks[axis] - 1);
+      }
+      bool reached = false;
+      for (int k = lower[2]; k <= upper[2] && !reached; ++k) {
+        for (int j = lower[1]; j <= upper[1] && !reached; ++j) {
+          for (int i = lower[0]; i <= upper[0] && !reached; ++i) {
+            int neighbour = getBrickIndex(i, j, k);
+            reached = !source.isConstant(neighbour) ||
+                      source.brick_min[neighbour] != source.brick_min[brick];
+          }
+        }
+      }
+      if (reached) {
+        computeRange(image_data, static_cast<int>(brick));
+      } else {
+        brick_min[brick] = source.brick_min[brick];
+        brick_max[brick] = source.brick_max[brick];
+      }
+    }
+  });
+}
+/*****************************************************************************/
+std::vector<std::array<int, 6>> BrickMap::getCrossingBlocks(
+    double value) const {
+  std::vector<std::array<int, 6>> blocks;
+  for (int k = 0; k != bricks[2]; ++k) {
+    for (int j = 0; j != bricks[1]; ++j) {
+      int first = -1;
+      for (int i = 0; i <= bricks[0]; ++i) {
+        int brick = getBrickIndex(std::min(i, bricks[0] - 1), j, k);
+        bool crossing = i != bricks[0] && brick_min[brick] < value &&
+                        brick_max[brick] >= value;
+        if (crossing && first < 0) {
+          first = i;
+        }
+        if (crossing || first < 0) {
+          continue;
+        }
+        std::array<int, 6> block;
+        int last_extent[6];
+        getBrickExtent(getBrickIndex(first, j, k), block.data());
+        getBrickExtent(getBrickIndex(i - 1, j, k), last_extent);
+        block[1] = last_extent[1];
+        blocks.push_back(block);
+        first = -1;
+      }
+    }
+  }
+  return blocks;
+}
+/*****************************************************************************/
+int BrickMap::getNumberOfBricks() const {
+  return bricks[0] * bricks[1] * bricks[2];
+}
+/*****************************************************************************/
+int BrickMap::getNumberOfNonConstantBricks() const {
+  int count = 0;
+  for (std::size_t i = 0; i != brick_min.size(); ++i) {
+    count += brick_min[i] != brick_max[i];
+  }
+  return count;
+}
+/*****************************************************************************/
+int BrickMap::getBrickSize() const { return brick_size; }
+/*****************************************************************************/
+void BrickMap::getBrickCounts(int* counts) const {
+  std::copy(bricks, bricks + 3, counts);
+}
+/*****************************************************************************/
+int BrickMap::getBrickIndex(int i, int j, int k) const {
+  return i + bricks[0] * (j + bricks[1] * k);
+}
+/*****************************************************************************/
+int BrickMap::getOwnerBrick(int axis, int voxel) const {
+  return std::min(voxel / brick_size, bricks[axis] - 1);
+}
+/*****************************************************************************/
+void BrickMap::getOwnedRange(int axis, int index, int* range) const {
+  // Полуинтервал [range[0], range[1]), последний блок - до края объёма
+  range[0] = index * brick_size;
+  range[1] = index + 1 == bricks[axis]
+                 ? image_extent[2 * axis + 1] - image_extent[2 * axis] + 1
+                 : range[0] + brick_size;
+}
+/*****************************************************************************/
+bool BrickMap::isConstant(int brick) const {
+  return brick_min[brick] == brick_max[brick];
+}
+/*****************************************************************************/
+double BrickMap::getBrickMin(int brick) const { return brick_min[brick]; }
+/*****************************************************************************/
+void BrickMap::init(vtkImageData* image_data, int brick_size_) {
+  if (brick_size_ < 1) {
+    throw std::runtime_error("Brick size must be positive");
+  }
+  if (image_data->GetNumberOfScalarComponents() != 1) {
+    throw std::runtime_error("BrickMap supports single component images");
+  }
+  brick_size = brick_size_;
+  image_data->GetExtent(image_extent);
+  for (int axis = 0; axis != 3; ++axis) {
+    int cells = image_extent[2 * axis + 1] - image_extent[2 * axis];
+    bricks[axis] = std::max(1, (cells + brick_size - 1) / brick_size);
+  }
+  brick_min.resize(getNumberOfBricks());
+  brick_max.resize(getNumberOfBricks());
+}
+/*****************************************************************************/
+void BrickMap::computeRange(vtkImageData* image_data, int brick) {
+  int extent[6];
+  getBrickExtent(brick, extent);
+  switch (image_data->GetScalarType()) {
+    vtkTemplateMacro(computeBrickRange<VTK_TT>(
+        image_data, extent, &brick_min[brick], &brick_max[brick]));
+  }
+}
+/*****************************************************************************/
+void BrickMap::getBrickExtent(int brick, int* extent) const {
+  int index[3] = {brick % bricks[0], (brick / bricks[0]) % bricks[1],
+                  brick / (bricks[0] * bricks[1])};
+  for (int axis = 0; axis != 3; ++axis) {
+    int lower = image_extent[2 * axis] + index[axis] * brick_size;
+    extent[2 * axis] = lower;
+    extent[2 * axis + 1] =
+        std::min(lower + brick_size, image_extent[2 * axis + 1]);
+  }
+}
+/*****************************************************************************/
+BrickActivity::BrickActivity(const BrickMap& bricks_) : bricks(bricks_) {
+  int count = bricks.getNumberOfBricks();
+  constant.resize(count);
+  value.resize(count);
+  for (int brick = 0; brick != count; ++brick) {
+    constant[brick] = bricks.isConstant(brick);
+    value[brick] = static_cast<float>(bricks.getBrickMin(brick));
+  }
+}
+/*****************************************************************************/
+std::vector<char> BrickActivity::getAffected(int axis, int reach) const {
+  int counts[3];
+  bricks.getBrickCounts(counts);
+  int brick_size = bricks.getBrickSize();
+  int brick_reach = (reach + brick_size - 1) / brick_size;
+  int stride = axis == 0 ? 1 : axis == 1 ? counts[0] : counts[0] * counts[1];
+  int count = bricks.getNumberOfBricks();
+
+  // Активны непостоянные блоки и постоянные на ступеньке к соседу с другим
+  // значением
+  std::vector<char> active(count);
+  for (int brick = 0; brick != count; ++brick) {
+    int position = brick / stride % counts[axis];
+    bool step = false;
+    if (position > 0 && constant[brick - stride]) {
+      step = step || value[brick - stride] != value[brick];
+    }
+    if (position + 1 < counts[axis] && constant[brick + stride]) {
+      step = step || value[brick + stride] != value[brick];
+    }
+    active[brick] = !constant[brick] || step;
+  }
+
+  std::vector<char> affected(count);
+  for (int brick = 0; brick != count; ++brick) {
+    int position = brick / stride % counts[axis];
+    int first = std::max(position - brick_reach, 0);
+    int last = std::min(position + brick_reach, counts[axis] - 1);
+    for (int i = first; i <= last && !affected[brick]; ++i) {
+      affected[brick] = active[brick + (i - position) * stride];
+    }
+  }
+  return affected;
+}
+/*****************************************************************************/
+void BrickActivity::update(const std::vector<char>& affected) {
+  for (std::size_t brick = 0; brick != constant.size(); ++brick) {
+    constant[brick] = constant[brick] && !affected[brick];
+  }
+}
+/*****************************************************************************/
+float BrickActivity::getValue(int brick) const { return value[brick]; }
+/*****************************************************************************/
@@ -0,0 +1,71 @@
+#ifndef BRICK_MAP
+#define BRICK_MAP
+
+#include <vtkImageData.h>
+
+#include <array>
+#include <vector>
+
+/*****************************************************************************/
+class BrickMap {
+ public:
+  // Соседние блоки перекрываются на один воксель, поэтому каждая ячейка
+  // объёма целиком лежит хотя бы в одном блоке
+  explicit BrickMap(vtkImageData* image_data, int brick_size_ = 16);
+  // Диапазоны результата свёртки source ядром радиуса reach: блоки, до
+  // которых ядро не достаёт от непостоянных блоков source, не читаются,
+  // их значение переносится из source
+  BrickMap(vtkImageData* image_data, const BrickMap& source, int reach);
+
+ public:
+  // Полосы подряд идущих вдоль x блоков, чей диапазон пересекает value
+  std::vector<std::array<int, 6>> getCrossingBlocks(double value) const;
+  int getNumberOfBricks() const;
+  int getNumberOfNonConstantBricks() const;
+
+ public:
+  // Обход по блокам без перекрытия: воксель принадлежит блоку, в котором
+  // он не последний. Индексы вокселей - от начала экстента
+  int getBrickSize() const;
+  void getBrickCounts(int* counts) const;
+  int getBrickIndex(int i, int j, int k) const;
+  int getOwnerBrick(int axis, int voxel) const;
+  void getOwnedRange(int axis, int index, int* range) const;
+  bool isConstant(int brick) const;
+  double getBrickMin(int brick) const;
+
+ private:
+  void init(vtkImageData* image_data, int brick_size_);
+  void computeRange(vtkImageData* image_data, int brick);
+  void getBrickExtent(int brick, int* extent) const;
+
+ private:
+  int brick_size;
+  int bricks[3];
+  int image_extent[6];
+  std::vector<double> brick_min;
+  std::vector<double> brick_max;
+};
+/*****************************************************************************/
+// Постоянные блоки данных между проходами разделимого фильтра. В отличие от
+// BrickMap постоянство относится к вокселям, которыми блок владеет
+class BrickActivity {
+ public:
+  explicit BrickActivity(const BrickMap& bricks_);
+
+ public:
+  // Блоки, значения которых может изменить свёртка вдоль axis ядром
+  // радиуса reach: рядом с непостоянным блоком или со ступенькой между
+  // постоянными. Остальные блоки постоянны и равны соседям вдоль axis
+  std::vector<char> getAffected(int axis, int reach) const;
+  // После прохода затронутые блоки считаются непостоянными
+  void update(const std::vector<char>& affected);
+  float getValue(int brick) const;
+
+ private:
+  const BrickMap& bricks;
+  std::vector<char> constant;
+  std::vector<float> value;
+};
+/*****************************************************************************/
+#endif  // BRICK_MAP
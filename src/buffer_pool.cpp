@@ -0,0 +1,140 @@
+#include "buffer_pool.h"
+
+#include <vtkPointData.h>
+
+/*****************************************************************************/
+BufferPool::BufferPool(std::size_t max_bytes_) {
+  max_bytes = max_bytes_;
+  pooled_bytes = 0;
+  requests = 0;
+  hits = 0;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkDataArray> BufferPool::acquireArray(int type,
+                                                       int components,
+                                                       vtkIdType tuples) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++requests;
+    requested_keys.insert(Key(type, components, tuples));
+    auto found = free_arrays.find(Key(type, components, tuples));
+    if (found != free_arrays.end() && !found->second.empty()) {
+      vtkSmartPointer<vtkDataArray> array = found->second.back();
+      found->second.pop_back();
+      pooled_bytes -= static_cast<std::size_t>(tuples) * components *
+                      array->GetDataTypeSize();
+      ++hits;
+      return array;
+    }
+  }
+
+  vtkSmartPointer<vtkDataArray> array;
+  array.TakeReference(vtkDataArray::CreateDataArray(type));
+  array->SetNumberOfComponents(components);
+  array->SetNumberOfTuples(tuples);
+  return array;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> BufferPool::acquireImage(const int* extent,
+                                                       const double* origin,
+                                                       const double* spacing,
+                                                       int type) {
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4],
+                   extent[5]);
+  image->SetOrigin(origin[0], origin[1], origin[2]);
+  image->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  vtkSmartPointer<vtkDataArray> scalars =
+      acquireArray(type, 1, image->GetNumberOfPoints());
+  scalars->SetName("ImageScalars");
+  image->GetPointData()->SetScalars(scalars);
+  return image;
+}
+/*****************************************************************************/
+void BufferPool::recycle(vtkImageData* image) {
+  if (!image || !image->GetPointData()->GetScalars()) {
+    return;
+  }
+  vtkSmartPointer<vtkDataArray> array = image->GetPointData()->GetScalars();
+  image->GetPointData()->Initialize();
+  // Массив ещё используется где-то кроме нас - в пул не берём
+  if (array->GetReferenceCount() != 1) {
+    return;
+  }
+
+  std::size_t size = static_cast<std::size_t>(array->GetNumberOfTuples()) *
+                     array->GetNumberOfComponents() *
+                     array->GetDataTypeSize();
+  std::lock_guard<std::mutex> lock(mutex);
+  if (pooled_bytes + size > max_bytes) {
+    return;
+  }
+  pooled_bytes += size;
+  free_arrays[Key(array->GetDataType(), array->GetNumberOfComponents(),
+                  array->GetNumberOfTuples())]
+      .push_back(array);
+}
+/*****************************************************************************/
+void BufferPool::trim() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = free_arrays.begin(); it != free_arrays.end();) {
+    if (requested_keys.count(it->first) == 0) {
+      for (const vtkSmartPointer<vtkDataArray>& array : it->second) {
+        pooled_bytes -= static_cast<std::size_t>(array->GetNumberOfTuples()) *
+                        array->GetNumberOfComponents() *
+                        array->GetDataTypeSize();
+      }
+      it = free_arrays.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  requested_keys.clear();
+}
+/*****************************************************************************/
+std::size_t BufferPool::getRequests() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return requests;
+}
+/*****************************************************************************/
+std::size_t BufferPool::getHits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return hits;
+}
+/*****************************************************************************/
+std::size_t BufferPool::getPooledBytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return pooled_bytes;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> BufferPool::allocateImage(BufferPool* pool,
+                                                        const int* extent,
+                                                        const double* origin,
+                                                        const double* spacing,
+                                                        int type) {
+  if (pool) {
+    return pool->acquireImage(extent, origin, spacing, type);
+  }
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4],
+                   extent[5]);
+  image->SetOrigin(origin[0], origin[1], origin[2]);
+  image->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  image->AllocateScalars(type, 1);
+  return image;
+}
+/*****************************************************************************/
+PooledImage::PooledImage(BufferPool* pool_,
+                         vtkSmartPointer<vtkImageData> image_)
+    : pool(pool_) {
+  image = image_;
+}
+/*****************************************************************************/
+PooledImage::~PooledImage() {
+  if (pool) {
+    pool->recycle(image);
+  }
+}
+/*****************************************************************************/
+vtkImageData* PooledImage::get() const { return image; }
+/*****************************************************************************/
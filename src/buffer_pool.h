@@ -0,0 +1,73 @@
+#ifndef BUFFER_POOL
+#define BUFFER_POOL
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+/*****************************************************************************/
+class BufferPool {
+ public:
+  explicit BufferPool(std::size_t max_bytes_);
+  BufferPool(BufferPool const&) = delete;
+  void operator=(BufferPool const&) = delete;
+
+ public:
+  // Массив того же типа и размера берётся из пула, иначе создаётся новый
+  vtkSmartPointer<vtkDataArray> acquireArray(int type, int components,
+                                             vtkIdType tuples);
+  vtkSmartPointer<vtkImageData> acquireImage(const int* extent,
+                                             const double* origin,
+                                             const double* spacing, int type);
+  // Забирает скаляры промежуточного изображения обратно в пул, если на них
+  // больше никто не ссылается. Само изображение после этого пустое
+  void recycle(vtkImageData* image);
+  // Освобождает массивы, которые не запрашивались с прошлого trim:
+  // остаётся только то, что понадобится повторной сборке
+  void trim();
+  std::size_t getRequests() const;
+  std::size_t getHits() const;
+  std::size_t getPooledBytes() const;
+
+  // Без пула просто выделяет новое изображение
+  static vtkSmartPointer<vtkImageData> allocateImage(BufferPool* pool,
+                                                     const int* extent,
+                                                     const double* origin,
+                                                     const double* spacing,
+                                                     int type);
+
+ private:
+  using Key = std::tuple<int, int, vtkIdType>;
+
+  std::size_t max_bytes;
+  std::size_t pooled_bytes;
+  std::size_t requests;
+  std::size_t hits;
+  std::map<Key, std::vector<vtkSmartPointer<vtkDataArray>>> free_arrays;
+  std::set<Key> requested_keys;
+  mutable std::mutex mutex;
+};
+/*****************************************************************************/
+class PooledImage {
+ public:
+  // Без пула (nullptr) ничего не возвращает
+  PooledImage(BufferPool* pool_, vtkSmartPointer<vtkImageData> image_);
+  ~PooledImage();
+  PooledImage(PooledImage const&) = delete;
+  void operator=(PooledImage const&) = delete;
+
+ public:
+  vtkImageData* get() const;
+
+ private:
+  BufferPool* pool;
+  vtkSmartPointer<vtkImageData> image;
+};
+/*****************************************************************************/
+#endif  // BUFFER_POOL
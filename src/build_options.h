@@ -0,0 +1,43 @@
+#ifndef BUILD_OPTIONS
+#define BUILD_OPTIONS
+
+#include <string>
+#include <vector>
+
+#include "label_classifier.h"
+
+/*****************************************************************************/
+// Все параметры одной сборки модели. Передаётся явно, поэтому несколько
+// сборок в одном процессе не делят общего состояния
+struct BuildOptions {
+  std::string mri_path;
+  // Серия дописывается сканером в mri_path во время сборки
+  bool streaming = false;
+  int streaming_expected_slices = 0;
+  double streaming_settle_seconds = 5;
+  // Серия из нескольких в исследовании; -1 - выбор по средним срезам в окне
+  // или, если задан triage_listing, по таблице в этом файле
+  int series_number = -1;
+  std::string triage_listing;
+  int triage_thumbnail_size = 128;
+  std::string model_path;
+  std::string model_name = "model";
+  double morph_radius = 5;
+  double threshold = 13;
+  double gauss_radius = 5;
+  double gauss_deviation = 2;
+  std::string smoothing_mode = "fir";
+  // Дополнительно строит поверхность другим режимом сглаживания и печатает
+  // время и расстояние Хаусдорфа между результатами
+  bool benchmark_smoothing = false;
+  std::vector<LabelRange> labels;
+  bool compress_volume = false;
+  std::string cache_path;
+  // 0 - размер кэша не ограничен
+  double cache_size_mb = 0;
+  // Пул промежуточных объёмов между пересборками, 0 - без пула
+  double buffer_pool_mb = 0;
+  bool visualizate_histogram = false;
+};
+/*****************************************************************************/
+#endif  // BUILD_OPTIONS
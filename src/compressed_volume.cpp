@@ -0,0 +1,287 @@
+#include "compressed_volume.h"
+
+#include <vtkLZ4DataCompressor.h>
+#include <vtkSMPTools.h>
+#include <vtkTypeTraits.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+/*****************************************************************************/
+namespace {
+template <typename T>
+void thresholdBrick(const T* in, T* out, const int* brick_extent,
+                    const vtkIdType* increments, double lower, double in_value,
+                    double out_value) {
+  // Как в vtkImageThreshold: значения вне диапазона типа обрезаются
+  double type_min = vtkTypeTraits<T>::Min();
+  double type_max = vtkTypeTraits<T>::Max();
+  T in_scalar = static_cast<T>(std::clamp(in_value, type_min, type_max));
+  T out_scalar = static_cast<T>(std::clamp(out_value, type_min, type_max));
+
+  int nx = brick_extent[1] - brick_extent[0] + 1;
+  int ny = brick_extent[3] - brick_extent[2] + 1;
+  int nz = brick_extent[5] - brick_extent[4] + 1;
+  for (int k = 0; k != nz; ++k) {
+    for (int j = 0; j != ny; ++j) {
+      const T* src = in + (static_cast<vtkIdType>(k) * ny + j) * nx;
+      T* dst = out + k * increments[2] + j * increments[1];
+      for (int i = 0; i != nx; ++i) {
+        dst[i] = static_cast<double>(src[i]) <= lower ? in_scalar : out_scalar;
+      }
+    }
+  }
+}
+}  // namespace
+/*****************************************************************************/
+CompressedVolume::CompressedVolume(vtkImageData* image_data, int brick_size_) {
+  if (brick_size_ < 1) {
+    throw std::runtime_error("Brick size must be positive");
+  }
+  if (image_data->GetNumberOfScalarComponents() != 1) {
+    throw std::runtime_error("CompressedVolume supports one component");
+  }
+  brick_size = brick_size_;
+  image_data->GetExtent(extent);
+  image_data->GetOrigin(origin);
+  image_data->GetSpacing(spacing);
+  scalar_type = image_data->GetScalarType();
+  scalar_size = image_data->GetScalarSize();
+  for (int axis = 0; axis != 3; ++axis) {
+    int points = extent[2 * axis + 1] - extent[2 * axis] + 1;
+    bricks[axis] = (points + brick_size - 1) / brick_size;
+  }
+
+  compressed_bricks.resize(
+      static_cast<std::size_t>(bricks[0]) * bricks[1] * bricks[2]);
+  std::atomic<bool> failed(false);
+  vtkSMPTools::For(
+      0, static_cast<vtkIdType>(compressed_bricks.size()),
+      [&](vtkIdType begin, vtkIdType end) {
+        for (vtkIdType brick = begin; brick != end && !failed; ++brick) {
+          if (!compressBrick(image_data, static_cast<int>(brick))) {
+            failed = true;
+          }
+        }
+      });
+  if (failed) {
+    throw std::runtime_error("Can't compress volume brick");
+  }
+
+  std::cout << "compressed volume: " << getUncompressedSize() << " -> "
+            << getCompressedSize() << " bytes" << std::endl;
+}
+/*****************************************************************************/
+void CompressedVolume::forEachBrick(
+    const std::function<void(const int* extent, const void* data)>& functor)
+    const {
+  std::atomic<bool> failed(false);
+  vtkSMPTools::For(
+      0, static_cast<vtkIdType>(compressed_bricks.size()),
+      [&](vtkIdType begin, vtkIdType end) {
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> shuffled;
+        for (vtkIdType brick = begin; brick != end && !failed; ++brick) {
+          int brick_extent[6];
+          getBrickExtent(static_cast<int>(brick), brick_extent);
+          data.resize(getBrickSize(brick_extent));
+          if (!decompressBrick(static_cast<int>(brick), data.data(),
+                               shuffled)) {
+            failed = true;
+            break;
+          }
+          functor(brick_extent, data.data());
+        }
+      });
+  if (failed) {
+    throw std::runtime_error("Can't decompress volume brick");
+  }
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> CompressedVolume::threshold(
+    double lower, double in_value, double out_value, BufferPool* pool) const {
+  vtkSmartPointer<vtkImageData> output = allocateImage(scalar_type, pool);
+  vtkIdType increments[3];
+  output->GetIncrements(increments);
+  forEachBrick([&](const int* brick_extent, const void* data) {
+    void* out = output->GetScalarPointer(brick_extent[0], brick_extent[2],
+                                         brick_extent[4]);
+    switch (scalar_type) {
+      vtkTemplateMacro(thresholdBrick(static_cast<const VTK_TT*>(data),
+                                      static_cast<VTK_TT*>(out), brick_extent,
+                                      increments, lower, in_value, out_value));
+    }
+  });
+  return output;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> CompressedVolume::decompress(
+    BufferPool* pool) const {
+  vtkSmartPointer<vtkImageData> output = allocateImage(scalar_type, pool);
+  forEachBrick([&](const int* brick_extent, const void* data) {
+    std::size_t row_size =
+        static_cast<std::size_t>(brick_extent[1] - brick_extent[0] + 1) *
+        scalar_size;
+    const unsigned char* src = static_cast<const unsigned char*>(data);
+    for (int k = brick_extent[4]; k <= brick_extent[5]; ++k) {
+      for (int j = brick_extent[2]; j <= brick_extent[3]; ++j) {
+        std::memcpy(output->GetScalarPointer(brick_extent[0], j, k), src,
+                    row_size);
+        src += row_size;
+      }
+    }
+  });
+  return output;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> CompressedVolume::extractVOI(
+    const int* voi, BufferPool* pool) const {
+  vtkSmartPointer<vtkImageData> output =
+      BufferPool::allocateImage(pool, voi, origin, spacing, scalar_type);
+
+  std::vector<unsigned char> data;
+  std::vector<unsigned char> shuffled;
+  for (int brick = 0; brick != static_cast<int>(compressed_bricks.size());
+       ++brick) {
+    int brick_extent[6];
+    getBrickExtent(brick, brick_extent);
+    int part[6];
+    bool intersects = true;
+    for (int axis = 0; axis != 3; ++axis) {
+      part[2 * axis] = std::max(brick_extent[2 * axis], voi[2 * axis]);
+      part[2 * axis + 1] =
+          std::min(brick_extent[2 * axis + 1], voi[2 * axis + 1]);
+      intersects = intersects && part[2 * axis] <= part[2 * axis + 1];
+    }
+    if (!intersects) {
+      continue;
+    }
+
+    data.resize(getBrickSize(brick_extent));
+    if (!decompressBrick(brick, data.data(), shuffled)) {
+      throw std::runtime_error("Can't decompress volume brick");
+    }
+    int nx = brick_extent[1] - brick_extent[0] + 1;
+    int ny = brick_extent[3] - brick_extent[2] + 1;
+    std::size_t row_size = static_cast<std::size_t>(part[1] - part[0] + 1) *
+                           scalar_size;
+    for (int k = part[4]; k <= part[5]; ++k) {
+      for (int j = part[2]; j <= part[3]; ++j) {
+        std::size_t index =
+            (static_cast<std::size_t>(k - brick_extent[4]) * ny +
+             (j - brick_extent[2])) * nx + (part[0] - brick_extent[0]);
+        std::memcpy(output->GetScalarPointer(part[0], j, k),
+                    data.data() + index * scalar_size, row_size);
+      }
+    }
+  }
+  return output;
+}
+/*****************************************************************************/
+void CompressedVolume::getExtent(int* extent_) const {
+  std::copy(extent, extent + 6, extent_);
+}
+/*****************************************************************************/
+std::size_t CompressedVolume::getCompressedSize() const {
+  std::size_t size = 0;
+  for (const std::vector<unsigned char>& brick : compressed_bricks) {
+    size += brick.size();
+  }
+  return size;
+}
+/*****************************************************************************/
+std::size_t CompressedVolume::getUncompressedSize() const {
+  std::size_t size = scalar_size;
+  for (int axis = 0; axis != 3; ++axis) {
+    size *= extent[2 * axis + 1] - extent[2 * axis] + 1;
+  }
+  return size;
+}
+/*****************************************************************************/
+int CompressedVolume::getScalarType() const { return scalar_type; }
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> CompressedVolume::allocateImage(
+    int type, BufferPool* pool) const {
+  return BufferPool::allocateImage(pool, extent, origin, spacing, type);
+}
+/*****************************************************************************/
+void CompressedVolume::getBrickExtent(int brick, int* brick_extent) const {
+  int index[3] = {brick % bricks[0], (brick / bricks[0]) % bricks[1],
+                  brick / (bricks[0] * bricks[1])};
+  for (int axis = 0; axis != 3; ++axis) {
+    int lower = extent[2 * axis] + index[axis] * brick_size;
+    brick_extent[2 * axis] = lower;
+    brick_extent[2 * axis + 1] =
+        std::min(lower + brick_size - 1, extent[2 * axis + 1]);
+  }
+}
+/*****************************************************************************/
+std::size_t CompressedVolume::getBrickSize(const int* brick_extent) const {
+  std::size_t size = scalar_size;
+  for (int axis = 0; axis != 3; ++axis) {
+    size *= brick_extent[2 * axis + 1] - brick_extent[2 * axis] + 1;
+  }
+  return size;
+}
+/*****************************************************************************/
+bool CompressedVolume::compressBrick(vtkImageData* image_data, int brick) {
+  int brick_extent[6];
+  getBrickExtent(brick, brick_extent);
+  std::size_t size = getBrickSize(brick_extent);
+  std::size_t values = size / scalar_size;
+
+  // Byte-shuffle: сначала все младшие байты, затем старшие. У 16-битных
+  // данных старшие байты почти постоянны и хорошо сжимаются
+  std::vector<unsigned char> shuffled(size);
+  std::size_t index = 0;
+  for (int k = brick_extent[4]; k <= brick_extent[5]; ++k) {
+    for (int j = brick_extent[2]; j <= brick_extent[3]; ++j) {
+      const unsigned char* row = static_cast<const unsigned char*>(
+          image_data->GetScalarPointer(brick_extent[0], j, k));
+      for (int i = 0; i <= brick_extent[1] - brick_extent[0]; ++i) {
+        for (int byte = 0; byte != scalar_size; ++byte) {
+          shuffled[byte * values + index] = row[i * scalar_size + byte];
+        }
+        ++index;
+      }
+    }
+  }
+
+  vtkNew<vtkLZ4DataCompressor> compressor;
+  vtkSmartPointer<vtkUnsignedCharArray> compressed;
+  compressed.TakeReference(compressor->Compress(shuffled.data(), size));
+  if (!compressed) {
+    return false;
+  }
+  const unsigned char* begin = compressed->GetPointer(0);
+  compressed_bricks[brick].assign(begin,
+                                  begin + compressed->GetNumberOfValues());
+  return true;
+}
+/*****************************************************************************/
+bool CompressedVolume::decompressBrick(
+    int brick, unsigned char* data, std::vector<unsigned char>& shuffled) const {
+  int brick_extent[6];
+  getBrickExtent(brick, brick_extent);
+  std::size_t size = getBrickSize(brick_extent);
+  std::size_t values = size / scalar_size;
+  shuffled.resize(size);
+
+  vtkNew<vtkLZ4DataCompressor> compressor;
+  const std::vector<unsigned char>& source = compressed_bricks[brick];
+  if (compressor->Uncompress(source.data(), source.size(), shuffled.data(),
+                             size) != size) {
+    return false;
+  }
+  for (std::size_t i = 0; i != values; ++i) {
+    for (int byte = 0; byte != scalar_size; ++byte) {
+      data[i * scalar_size + byte] = shuffled[byte * values + i];
+    }
+  }
+  return true;
+}
+/*****************************************************************************/
@@ -0,0 +1,59 @@
+#ifndef COMPRESSED_VOLUME
+#define COMPRESSED_VOLUME
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <functional>
+#include <vector>
+
+#include "buffer_pool.h"
+
+/*****************************************************************************/
+class CompressedVolume {
+ public:
+  explicit CompressedVolume(vtkImageData* image_data, int brick_size_ = 32);
+
+ public:
+  // Блоки распаковываются по требованию во временный буфер потока и
+  // передаются в функтор вместе со своим экстентом. Функтор вызывается
+  // параллельно для разных блоков
+  void forEachBrick(
+      const std::function<void(const int* extent, const void* data)>& functor)
+      const;
+  // Выходные буферы берутся из pool, если он задан
+  vtkSmartPointer<vtkImageData> threshold(double lower, double in_value,
+                                          double out_value,
+                                          BufferPool* pool = nullptr) const;
+  vtkSmartPointer<vtkImageData> decompress(BufferPool* pool = nullptr) const;
+  // Распаковывает только блоки, пересекающие voi
+  vtkSmartPointer<vtkImageData> extractVOI(const int* voi,
+                                           BufferPool* pool = nullptr) const;
+  void getExtent(int* extent_) const;
+  std::size_t getCompressedSize() const;
+  std::size_t getUncompressedSize() const;
+  int getScalarType() const;
+
+ private:
+  vtkSmartPointer<vtkImageData> allocateImage(int type,
+                                              BufferPool* pool) const;
+  void getBrickExtent(int brick, int* extent) const;
+  std::size_t getBrickSize(const int* extent) const;
+  // Вызываются из потоков vtkSMPTools, поэтому ошибку возвращают, а не
+  // бросают
+  bool compressBrick(vtkImageData* image_data, int brick);
+  bool decompressBrick(int brick, unsigned char* data,
+                       std::vector<unsigned char>& shuffled) const;
+
+ private:
+  int brick_size;
+  int bricks[3];
+  int extent[6];
+  double origin[3];
+  double spacing[3];
+  int scalar_type;
+  int scalar_size;
+  std::vector<std::vector<unsigned char>> compressed_bricks;
+};
+/*****************************************************************************/
+#endif  // COMPRESSED_VOLUME
@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <fstream>
+#include <iostream>
 
 /*****************************************************************************/
 ConfigReader::ConfigReader(const std::string& path) {
@@ -17,15 +18,76 @@ ConfigReader::ConfigReader(const std::string& path) {
   file.close();
 }
 /*****************************************************************************/
-ConfigReader* ConfigReader::getInstance(const std::string& path) {
-  if (reader == nullptr) {
-    reader = new ConfigReader(path);
+BuildOptions ConfigReader::getBuildOptions() {
+  BuildOptions options;
+  options.mri_path = getMriPath();
+
+  // Сохранение, кэш и дополнительные режимы необязательны: значение по
+  // умолчанию остаётся только при отсутствии ключа, неверное значение -
+  // исключение, а не молча подставленное умолчание
+  if (config.isMember("model_path")) {
+    options.model_path = getModelPath();
+  }
+  if (config.isMember("model_name")) {
+    options.model_name = getModelName();
+  }
+  if (config.isMember("morph_radius")) {
+    options.morph_radius = getMorphRadius();
+  }
+  if (config.isMember("gauss_radius")) {
+    options.gauss_radius = getGaussRadius();
+  }
+  if (config.isMember("gauss_deviation")) {
+    options.gauss_deviation = getGaussDeviation();
+  }
+  if (config.isMember("threshold")) {
+    options.threshold = getThreshold();
+  }
+  if (config.isMember("smoothing_mode")) {
+    options.smoothing_mode = getSmoothingMode();
+  }
+  if (config.isMember("benchmark_smoothing")) {
+    options.benchmark_smoothing = getBenchmarkSmoothing();
+  }
+  if (config.isMember("labels")) {
+    options.labels = getLabels();
+  }
+  if (config.isMember("compress_volume")) {
+    options.compress_volume = getCompressVolume();
+  }
+  if (config.isMember("cache_path")) {
+    options.cache_path = getCachePath();
+  }
+  if (config.isMember("cache_size_mb")) {
+    options.cache_size_mb = getCacheSizeMb();
+  }
+  if (config.isMember("buffer_pool_mb")) {
+    options.buffer_pool_mb = getBufferPoolMb();
+  }
+  if (config.isMember("streaming")) {
+    options.streaming = getStreaming();
+  }
+  if (config.isMember("streaming_expected_slices")) {
+    options.streaming_expected_slices = getStreamingExpectedSlices();
+  }
+  if (config.isMember("streaming_settle_seconds")) {
+    options.streaming_settle_seconds = getStreamingSettleSeconds();
+  }
+  if (config.isMember("series_number")) {
+    options.series_number = getSeriesNumber();
   }
-  return reader;
+  if (config.isMember("triage_listing")) {
+    options.triage_listing = getTriageListing();
+  }
+  if (config.isMember("triage_thumbnail_size")) {
+    options.triage_thumbnail_size = getTriageThumbnailSize();
+  }
+  if (config.isMember("visualizate_histogram")) {
+    options.visualizate_histogram = getVisualizateHistogram();
+  }
+  return options;
 }
 /*****************************************************************************/
-ConfigReader* ConfigReader::getInstance() { return reader; }
-/*****************************************************************************/
 Json::Value ConfigReader::getParamByName(const std::string& name) {
   if (!config.isMember(name)) {
     throw std::runtime_error("No member with key " + name);
@@ -33,35 +95,162 @@ Json::Value ConfigReader::getParamByName(const std::string& name) {
   return config[name];
 }
 /*****************************************************************************/
+std::string ConfigReader::getString(const std::string& name) {
+  Json::Value value = getParamByName(name);
+  if (!value.isString()) {
+    throw std::runtime_error("Key " + name + " must be a string");
+  }
+  return value.asString();
+}
+/*****************************************************************************/
+double ConfigReader::getNumber(const std::string& name) {
+  Json::Value value = getParamByName(name);
+  if (!value.isNumeric()) {
+    throw std::runtime_error("Key " + name + " must be a number");
+  }
+  return value.asDouble();
+}
+/*****************************************************************************/
+double ConfigReader::getNonNegative(const std::string& name) {
+  Json::Value value = getParamByName(name);
+  if (!value.isNumeric() || value.asDouble() < 0) {
+    throw std::runtime_error("Key " + name + " must be a non-negative number");
+  }
+  return value.asDouble();
+}
+/*****************************************************************************/
+int ConfigReader::getInt(const std::string& name) {
+  Json::Value value = getParamByName(name);
+  if (!value.isInt()) {
+    throw std::runtime_error("Key " + name + " must be an integer");
+  }
+  return value.asInt();
+}
+/*****************************************************************************/
+bool ConfigReader::getBool(const std::string& name) {
+  Json::Value value = getParamByName(name);
+  if (!value.isBool()) {
+    throw std::runtime_error("Key " + name + " must be true or false");
+  }
+  return value.asBool();
+}
+/*****************************************************************************/
 std::string ConfigReader::getMriPath() {
-  return getParamByName("mri_path").asString();
+  return getString("mri_path");
 }
 /*****************************************************************************/
 std::string ConfigReader::getModelPath() {
-  return getParamByName("model_path").asString();
+  return getString("model_path");
 }
 /*****************************************************************************/
 std::string ConfigReader::getModelName() {
-  return getParamByName("model_name").asString();
+  return getString("model_name");
 }
 /*****************************************************************************/
 double ConfigReader::getMorphRadius() {
-  return getParamByName("morph_radius").asDouble();
+  return getNonNegative("morph_radius");
 }
 /*****************************************************************************/
 double ConfigReader::getThreshold() {
-  return getParamByName("threshold").asDouble();
+  return getNumber("threshold");
 }
 /*****************************************************************************/
 double ConfigReader::getGaussRadius() {
-  return getParamByName("gauss_radius").asDouble();
+  return getNonNegative("gauss_radius");
 }
 /*****************************************************************************/
 double ConfigReader::getGaussDeviation() {
-  return getParamByName("gauss_deviation").asDouble();
+  return getNonNegative("gauss_deviation");
 }
 /*****************************************************************************/
 bool ConfigReader::getVisualizateHistogram() {
-  return getParamByName("visualizate_histogram").asBool();
+  return getBool("visualizate_histogram");
+}
+/*****************************************************************************/
+std::vector<LabelRange> ConfigReader::getLabels() {
+  Json::Value labels = getParamByName("labels");
+  if (!labels.isArray()) {
+    throw std::runtime_error("Key labels must be an array");
+  }
+  std::vector<LabelRange> result;
+  for (const Json::Value& label : labels) {
+    if (!label.isObject() || !label["name"].isString() ||
+        !label["lower"].isNumeric() || !label["upper"].isNumeric()) {
+      throw std::runtime_error(
+          "Label must have a name and numeric lower and upper bounds");
+    }
+    LabelRange range;
+    range.name = label["name"].asString();
+    range.lower = label["lower"].asDouble();
+    range.upper = label["upper"].asDouble();
+    if (!LabelClassifier::isValidName(range.name) ||
+        range.lower > range.upper) {
+      throw std::runtime_error("Invalid label " + range.name);
+    }
+    result.push_back(range);
+  }
+  return result;
+}
+/*****************************************************************************/
+std::string ConfigReader::getSmoothingMode() {
+  std::string mode = getString("smoothing_mode");
+  if (mode != "fir" && mode != "iir" && mode != "mesh") {
+    throw std::runtime_error("Unknown smoothing_mode " + mode);
+  }
+  return mode;
+}
+/*****************************************************************************/
+bool ConfigReader::getBenchmarkSmoothing() {
+  return getBool("benchmark_smoothing");
+}
+/*****************************************************************************/
+std::string ConfigReader::getCachePath() {
+  return getString("cache_path");
+}
+/*****************************************************************************/
+double ConfigReader::getCacheSizeMb() {
+  return getNonNegative("cache_size_mb");
+}
+/*****************************************************************************/
+bool ConfigReader::getCompressVolume() {
+  return getBool("compress_volume");
+}
+/*****************************************************************************/
+double ConfigReader::getBufferPoolMb() {
+  return getNonNegative("buffer_pool_mb");
+}
+/*****************************************************************************/
+bool ConfigReader::getStreaming() {
+  return getBool("streaming");
+}
+/*****************************************************************************/
+int ConfigReader::getStreamingExpectedSlices() {
+  int slices = getInt("streaming_expected_slices");
+  if (slices < 0) {
+    throw std::runtime_error("Key streaming_expected_slices must not be "
+                             "negative");
+  }
+  return slices;
+}
+/*****************************************************************************/
+double ConfigReader::getStreamingSettleSeconds() {
+  return getNonNegative("streaming_settle_seconds");
+}
+/*****************************************************************************/
+int ConfigReader::getSeriesNumber() {
+  // -1 - серия выбирается автоматически
+  return getInt("series_number");
+}
+/*****************************************************************************/
+std::string ConfigReader::getTriageListing() {
+  return getString("triage_listing");
+}
+/*****************************************************************************/
+int ConfigReader::getTriageThumbnailSize() {
+  int size = getInt("triage_thumbnail_size");
+  if (size <= 0) {
+    throw std::runtime_error("Key triage_thumbnail_size must be positive");
+  }
+  return size;
 }
 /*****************************************************************************/
\ No newline at end of file
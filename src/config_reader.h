@@ -3,17 +3,18 @@
 
 #include <jsoncpp/json/json.h>
 
+#include <vector>
+
+#include "build_options.h"
+#include "label_classifier.h"
+
 /*****************************************************************************/
 class ConfigReader {
- private:
+ public:
   explicit ConfigReader(const std::string& path);
 
  public:
-  static ConfigReader* getInstance(const std::string& path);
-  static ConfigReader* getInstance();
-  ConfigReader(ConfigReader const&) = delete;
-  void operator=(ConfigReader const&) = delete;
-
+  BuildOptions getBuildOptions();
   Json::Value getParamByName(const std::string& name);
   std::string getMriPath();
   std::string getModelPath();
@@ -23,9 +24,29 @@ class ConfigReader {
   double getGaussRadius();
   double getGaussDeviation();
   bool getVisualizateHistogram();
+  std::vector<LabelRange> getLabels();
+  std::string getSmoothingMode();
+  bool getBenchmarkSmoothing();
+  std::string getCachePath();
+  double getCacheSizeMb();
+  bool getCompressVolume();
+  double getBufferPoolMb();
+  bool getStreaming();
+  int getStreamingExpectedSlices();
+  double getStreamingSettleSeconds();
+  int getSeriesNumber();
+  std::string getTriageListing();
+  int getTriageThumbnailSize();
+
+ private:
+  // Проверяют тип значения ключа, а не только его наличие
+  std::string getString(const std::string& name);
+  double getNumber(const std::string& name);
+  double getNonNegative(const std::string& name);
+  int getInt(const std::string& name);
+  bool getBool(const std::string& name);
 
  private:
-  inline static ConfigReader* reader = nullptr;
   std::string path;
   Json::Value config;
 };
@@ -10,25 +10,75 @@
 
 #include <filesystem>
 
+#include "dicom_tags.h"
+#include "mapped_pixel_reader.h"
+#include "streaming_ingestor.h"
+
 /*****************************************************************************/
-DcmReader::DcmReader(const std::string& path) {
-  dcm_dir_path = path;
+DcmReader::DcmReader(const BuildOptions& options) {
+  dcm_dir_path = options.mri_path;
   if (!std::filesystem::exists(dcm_dir_path)) {
     throw std::runtime_error("No data found at " + dcm_dir_path);
   }
+  if (options.streaming) {
+    initStreamingImageData(options);
+    return;
+  }
   initDcmDirectory();
   checkSeveralStudies();
-  checkSeveralSeries();
+  checkSeveralSeries(options.series_number);
+  if (isSeriesSelected()) {
+    initImageData();
+  }
+}
+/*****************************************************************************/
+bool DcmReader::isSeriesSelected() const {
+  // В потоковом режиме серия одна - та, что пишется в каталог
+  return !dcm_dir || series_number >= 0;
+}
+/*****************************************************************************/
+SeriesTriage DcmReader::triageSeries(int thumbnail_size) {
+  if (!dcm_dir) {
+    throw std::runtime_error("No series to choose in streaming mode");
+  }
+  SeriesTriage triage(dcm_dir, study_number, thumbnail_size);
+  triage.run();
+  return triage;
+}
+/*****************************************************************************/
+void DcmReader::selectSeries(int series) {
+  if (!dcm_dir) {
+    throw std::runtime_error("No series to choose in streaming mode");
+  }
+  checkSeriesNumber(series);
+  series_number = series;
+  std::cout << "Выбрана серия №" << series_number << std::endl;
   initImageData();
 }
 /*****************************************************************************/
-vtkSmartPointer<vtkImageData> DcmReader::getImageData() { return image_data; }
+vtkSmartPointer<vtkImageData> DcmReader::getImageData() {
+  if (!isSeriesSelected()) {
+    throw std::runtime_error("Series is not selected");
+  }
+  return image_data;
+}
+/*****************************************************************************/
+void DcmReader::releaseImageData() { image_data = nullptr; }
 /*****************************************************************************/
 vtkDICOMValue DcmReader::getMetaData(const vtkDICOMTag& tag) {
+  if (!dcm_dir) {
+    throw std::runtime_error("No series metadata in streaming mode");
+  }
   vtkDICOMMetaData* meta = dcm_dir->GetMetaDataForSeries(series_number);
   return meta->Get(tag);
 }
 /*****************************************************************************/
+std::string DcmReader::getVolumeKey() {
+  // Число срезов отличает серию, оборванную потоковым приёмом, от полной
+  return series_uid + ";slices:" + std::to_string(number_of_slices) + ";" +
+         preprocessing;
+}
+/*****************************************************************************/
 void DcmReader::initDcmDirectory() {
   dcm_dir = vtkSmartPointer<vtkDICOMDirectory>::New();
   dcm_dir->RequirePixelDataOn();
@@ -50,45 +100,75 @@ void DcmReader::checkSeveralStudies() {
   study_number = 0;
 }
 /*****************************************************************************/
-void DcmReader::checkSeveralSeries() {
+void DcmReader::checkSeveralSeries(int requested_series) {
   int first_series = dcm_dir->GetFirstSeriesForStudy(study_number);
   int last_series = dcm_dir->GetLastSeriesForStudy(study_number);
-  if (first_series != last_series) {
-    std::cout << "Обнаружено " << last_series - first_series + 1
-              << " серий в исследовании. Выберите необходимую серию:"
-              << std::endl;
-    std::cout << "№ |" << " description |" << " modality |" << " rows x cols |"
-              << " slices " << std::endl;
-    for (int i = first_series; i <= last_series; ++i) {
-      vtkDICOMMetaData* meta = dcm_dir->GetMetaDataForSeries(i);
-      vtkDICOMValue description = meta->Get(description_tag);
-      vtkDICOMValue modality = meta->Get(modality_tag);
-      vtkDICOMValue rows = meta->Get(rows_tag);
-      vtkDICOMValue cols = meta->Get(cols_tag);
-      int slices = dcm_dir->GetFileNamesForSeries(i)->GetNumberOfValues();
-      std::cout << i << " | " << description.AsString() << " | "
-                << modality.AsString() << " | " << rows.AsString() << "x"
-                << cols.AsString() << " | " << slices << std::endl;
-    }
-    std::cin >> series_number;
-    std::cout << "Выбрана серия №" << series_number << std::endl;
+  if (first_series == last_series) {
+    series_number = first_series;
     return;
   }
-  series_number = first_series;
+  std::cout << "Обнаружено " << last_series - first_series + 1
+            << " серий в исследовании" << std::endl;
+  // Номер серии из конфига, иначе выбор после просмотра срезов
+  series_number = -1;
+  if (requested_series >= 0) {
+    checkSeriesNumber(requested_series);
+    series_number = requested_series;
+    std::cout << "Выбрана серия №" << series_number << std::endl;
+  }
+}
+/*****************************************************************************/
+void DcmReader::checkSeriesNumber(int series) {
+  int first_series = dcm_dir->GetFirstSeriesForStudy(study_number);
+  int last_series = dcm_dir->GetLastSeriesForStudy(study_number);
+  if (series < first_series || series > last_series) {
+    throw std::runtime_error("Нет серии №" + std::to_string(series) +
+                             " в исследовании");
+  }
 }
 /*****************************************************************************/
 void DcmReader::initImageData() {
   vtkSmartPointer<vtkStringArray> filenames =
       dcm_dir->GetFileNamesForSeries(series_number);
 
-  vtkNew<vtkDICOMReader> reader;
+  vtkNew<vtkMappedDICOMReader> reader;
   reader->SetFileNames(filenames);
   reader->SetMemoryRowOrderToFileNative();
   reader->UpdateInformation();
-  reader->Update();
+
+  // Несжатые серии копируются прямо из отображённых в память файлов
+  vtkSmartPointer<vtkImageData> volume;
+  MappedPixelReader mapped_reader(reader);
+  if (mapped_reader.canRead()) {
+    volume = mapped_reader.read();
+  }
+  if (volume) {
+    std::cout << "pixel data: memory mapped" << std::endl;
+  } else {
+    reader->Update();
+    volume = reader->GetOutput();
+  }
+
+  series_uid = getMetaData(DicomTags::series_uid_tag).AsString();
+  preprocessImage(volume, reader->GetPatientMatrix());
+}
+/*****************************************************************************/
+void DcmReader::initStreamingImageData(const BuildOptions& options) {
+  StreamingIngestor ingestor(dcm_dir_path, options.streaming_expected_slices,
+                             options.streaming_settle_seconds);
+  ingestor.run();
+  series_uid = ingestor.getSeriesUid();
+  preprocessImage(ingestor.getImageData(), ingestor.getPatientMatrix());
+}
+/*****************************************************************************/
+void DcmReader::preprocessImage(vtkImageData* volume,
+                                vtkMatrix4x4* volume_matrix) {
+  int dims_volume[3];
+  volume->GetDimensions(dims_volume);
+  number_of_slices = dims_volume[2];
 
   vtkNew<vtkMatrix4x4> patient_matrix;
-  patient_matrix->DeepCopy(reader->GetPatientMatrix());
+  patient_matrix->DeepCopy(volume_matrix);
   patient_matrix->Invert();
 
   vtkNew<vtkTransform> transform;
@@ -96,7 +176,7 @@ void DcmReader::initImageData() {
   transform->Update();
 
   vtkNew<vtkImageReslice> reslice;
-  reslice->SetInputData(reader->GetOutput());
+  reslice->SetInputData(volume);
   reslice->SetResliceTransform(transform);
   reslice->SetInterpolationModeToLinear();
   reslice->AutoCropOutputOn();
@@ -139,5 +219,8 @@ void DcmReader::initImageData() {
             << bounds_resample[5] << "]" << std::endl;
 
   image_data = resample->GetOutput();
+  // Диапазон кэшируется в массиве сейчас, пока объём ещё не разделён между
+  // потоками сборки
+  image_data->GetScalarRange();
 }
 /*****************************************************************************/
@@ -5,36 +5,49 @@
 #include <vtkDICOMTag.h>
 #include <vtkDICOMValue.h>
 #include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkSmartPointer.h>
 
+#include "build_options.h"
+#include "series_triage.h"
+
 /*****************************************************************************/
 class DcmReader {
  public:
-  explicit DcmReader(const std::string& path);
+  explicit DcmReader(const BuildOptions& options);
 
  public:
+  // При нескольких сериях без series_number объём не читается, пока серия
+  // не выбрана через selectSeries
+  bool isSeriesSelected() const;
+  SeriesTriage triageSeries(int thumbnail_size);
+  void selectSeries(int series);
   vtkSmartPointer<vtkImageData> getImageData();
+  void releaseImageData();
   vtkDICOMValue getMetaData(const vtkDICOMTag& tag);
+  std::string getVolumeKey();
 
  private:
   void initDcmDirectory();
   void checkSeveralStudies();
-  void checkSeveralSeries();
+  void checkSeveralSeries(int requested_series);
+  void checkSeriesNumber(int series);
   void initImageData();
+  void initStreamingImageData(const BuildOptions& options);
+  void preprocessImage(vtkImageData* volume, vtkMatrix4x4* volume_matrix);
 
  private:
-  int study_number;
-  int series_number;
+  int study_number = 0;
+  int series_number = -1;
+  int number_of_slices = 0;
   std::string dcm_dir_path;
+  std::string series_uid;
   vtkSmartPointer<vtkDICOMDirectory> dcm_dir;
   vtkSmartPointer<vtkImageData> image_data;
 
  public:
-  const vtkDICOMTag rows_tag = vtkDICOMTag(0x0028, 0x0010);
-  const vtkDICOMTag cols_tag = vtkDICOMTag(0x0028, 0x0011);
-  const vtkDICOMTag slices_tag = vtkDICOMTag(0x0054, 0x0081);
-  const vtkDICOMTag modality_tag = vtkDICOMTag(0x0008, 0x0060);
-  const vtkDICOMTag description_tag = vtkDICOMTag(0x0008, 0x103e);
+  // Меняется вместе с любым изменением предобработки в initImageData
+  inline static const std::string preprocessing = "reslice:linear;resample:255";
 };
 /*****************************************************************************/
 #endif  //  DCM_READER
\ No newline at end of file
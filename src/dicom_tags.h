@@ -0,0 +1,33 @@
+#ifndef DICOM_TAGS
+#define DICOM_TAGS
+
+#include <vtkDICOMTag.h>
+
+/*****************************************************************************/
+// Теги метаданных, общие для всех читателей серий
+struct DicomTags {
+  inline static const vtkDICOMTag transfer_syntax_tag =
+      vtkDICOMTag(0x0002, 0x0010);
+  inline static const vtkDICOMTag modality_tag = vtkDICOMTag(0x0008, 0x0060);
+  inline static const vtkDICOMTag description_tag =
+      vtkDICOMTag(0x0008, 0x103e);
+  inline static const vtkDICOMTag series_uid_tag = vtkDICOMTag(0x0020, 0x000e);
+  inline static const vtkDICOMTag images_in_acquisition_tag =
+      vtkDICOMTag(0x0020, 0x1002);
+  inline static const vtkDICOMTag samples_tag = vtkDICOMTag(0x0028, 0x0002);
+  inline static const vtkDICOMTag frames_tag = vtkDICOMTag(0x0028, 0x0008);
+  inline static const vtkDICOMTag rows_tag = vtkDICOMTag(0x0028, 0x0010);
+  inline static const vtkDICOMTag cols_tag = vtkDICOMTag(0x0028, 0x0011);
+  inline static const vtkDICOMTag bits_allocated_tag =
+      vtkDICOMTag(0x0028, 0x0100);
+  inline static const vtkDICOMTag bits_stored_tag = vtkDICOMTag(0x0028, 0x0101);
+  inline static const vtkDICOMTag high_bit_tag = vtkDICOMTag(0x0028, 0x0102);
+  inline static const vtkDICOMTag pixel_representation_tag =
+      vtkDICOMTag(0x0028, 0x0103);
+  inline static const vtkDICOMTag rescale_intercept_tag =
+      vtkDICOMTag(0x0028, 0x1052);
+  inline static const vtkDICOMTag rescale_slope_tag =
+      vtkDICOMTag(0x0028, 0x1053);
+};
+/*****************************************************************************/
+#endif  // DICOM_TAGS
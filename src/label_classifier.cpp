@@ -0,0 +1,71 @@
+#include "label_classifier.h"
+
+#include <vtkSMPTools.h>
+
+#include <stdexcept>
+
+/*****************************************************************************/
+namespace {
+template <typename T>
+void classifyVoxels(const T* in, unsigned char* out, vtkIdType slice_size,
+                    int slices, const std::vector<LabelRange>& labels) {
+  vtkSMPTools::For(0, slices, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType idx = begin * slice_size; idx != end * slice_size; ++idx) {
+      double value = static_cast<double>(in[idx]);
+      unsigned char label = 0;
+      for (std::size_t i = 0; i != labels.size(); ++i) {
+        if (value >= labels[i].lower && value <= labels[i].upper) {
+          label = static_cast<unsigned char>(i + 1);
+          break;
+        }
+      }
+      out[idx] = label;
+    }
+  });
+}
+}  // namespace
+/*****************************************************************************/
+LabelClassifier::LabelClassifier(const std::vector<LabelRange>& labels_) {
+  if (labels_.empty()) {
+    throw std::runtime_error("No labels to classify");
+  }
+  if (labels_.size() > 255) {
+    throw std::runtime_error("Too many labels: " +
+                             std::to_string(labels_.size()));
+  }
+  labels = labels_;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> LabelClassifier::classify(
+    vtkImageData* input, BufferPool* pool) const {
+  int dims[3];
+  input->GetDimensions(dims);
+
+  vtkSmartPointer<vtkImageData> label_volume = BufferPool::allocateImage(
+      pool, input->GetExtent(), input->GetOrigin(), input->GetSpacing(),
+      VTK_UNSIGNED_CHAR);
+
+  unsigned char* out =
+      static_cast<unsigned char*>(label_volume->GetScalarPointer());
+  vtkIdType slice_size = static_cast<vtkIdType>(dims[0]) * dims[1];
+
+  switch (input->GetScalarType()) {
+    vtkTemplateMacro(classifyVoxels(
+        static_cast<const VTK_TT*>(input->GetScalarPointer()), out,
+        slice_size, dims[2], labels));
+    default:
+      throw std::runtime_error("Unsupported scalar type for classification");
+  }
+  return label_volume;
+}
+/*****************************************************************************/
+const std::vector<LabelRange>& LabelClassifier::getLabels() const {
+  return labels;
+}
+/*****************************************************************************/
+bool LabelClassifier::isValidName(const std::string& name) {
+  return !name.empty() && name.find_first_of("/\\") == std::string::npos &&
+         name.find("..") == std::string::npos &&
+         name.find('\0') == std::string::npos;
+}
+/*****************************************************************************/
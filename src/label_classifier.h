@@ -0,0 +1,37 @@
+#ifndef LABEL_CLASSIFIER
+#define LABEL_CLASSIFIER
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+#include <vector>
+
+#include "buffer_pool.h"
+
+/*****************************************************************************/
+struct LabelRange {
+  std::string name;
+  double lower;
+  double upper;
+};
+/*****************************************************************************/
+class LabelClassifier {
+ public:
+  explicit LabelClassifier(const std::vector<LabelRange>& labels_);
+
+ public:
+  // Один параллельный проход по объёму: каждому вокселю присваивается номер
+  // первого подходящего диапазона (1..N), 0 - фон
+  vtkSmartPointer<vtkImageData> classify(vtkImageData* input,
+                                         BufferPool* pool = nullptr) const;
+  const std::vector<LabelRange>& getLabels() const;
+  // Имя метки входит в имя файла модели: непустое, без разделителей пути
+  // и без ".."
+  static bool isValidName(const std::string& name);
+
+ private:
+  std::vector<LabelRange> labels;
+};
+/*****************************************************************************/
+#endif  // LABEL_CLASSIFIER
@@ -2,15 +2,34 @@
 #include "dcm_reader.h"
 #include "model_builder.h"
 #include "scene_provider.h"
+#include "series_selector.h"
 
 /*****************************************************************************/
 int main(int, char*[]) {
   try {
-    ConfigReader::getInstance("../import/config.json");
-    DcmReader dcm_reader(ConfigReader::getInstance()->getMriPath());
-    ModelBuilder model_builder(dcm_reader.getImageData());
-    SceneProvider::getInstance(&model_builder);
-    SceneProvider::getInstance()->start();
+    ConfigReader config_reader("../import/config.json");
+    BuildOptions options = config_reader.getBuildOptions();
+    DcmReader dcm_reader(options);
+    if (!dcm_reader.isSeriesSelected()) {
+      // Объём читается только после выбора серии
+      SeriesTriage triage =
+          dcm_reader.triageSeries(options.triage_thumbnail_size);
+      if (!options.triage_listing.empty()) {
+        // Список - результат запуска, а не ошибка: сборка продолжится
+        // после выбора series_number в конфиге
+        triage.writeListing(options.triage_listing);
+        std::cout << "Выберите series_number в конфиге по "
+                  << options.triage_listing << std::endl;
+        return EXIT_SUCCESS;
+      }
+      SeriesSelector selector(triage.getPreviews());
+      dcm_reader.selectSeries(selector.select());
+    }
+    ModelBuilder model_builder(dcm_reader.getImageData(),
+                               dcm_reader.getVolumeKey(), options);
+    dcm_reader.releaseImageData();
+    SceneProvider scene_provider(&model_builder, options);
+    scene_provider.start();
     return EXIT_SUCCESS;
   } catch (const std::exception& ex) {
     std::cerr << ex.what() << std::endl;
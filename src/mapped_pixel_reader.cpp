@@ -0,0 +1,228 @@
+#include "mapped_pixel_reader.h"
+
+#include <vtkDICOMMetaData.h>
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
+#include <vtkStringArray.h>
+#include <vtkTypeInt64Array.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "dicom_tags.h"
+
+/*****************************************************************************/
+vtkStandardNewMacro(vtkMappedDICOMReader);
+/*****************************************************************************/
+vtkTypeInt64 vtkMappedDICOMReader::getPixelDataOffset(int file_index) {
+  return FileOffsetArray->GetValue(file_index);
+}
+/*****************************************************************************/
+namespace {
+/*****************************************************************************/
+// Значение хранится в младших bits_stored битах, старшие могут быть заняты
+// оверлеями. Знаковые значения расширяются из старшего хранимого бита
+template <class IT, class OT>
+void convertPixels(const IT* source, OT* destination, std::size_t count,
+                   const MappedPixelReader::PixelFormat& format) {
+  const int mask = (1 << format.bits_stored) - 1;
+  const int sign_bit = 1 << (format.bits_stored - 1);
+  const bool rescale = format.slope != 1.0 || format.intercept != 0.0;
+  for (std::size_t i = 0; i != count; ++i) {
+    int value = static_cast<int>(source[i]) & mask;
+    if (format.is_signed && (value & sign_bit)) {
+      value -= mask + 1;
+    }
+    destination[i] =
+        rescale ? static_cast<OT>(value * format.slope + format.intercept)
+                : static_cast<OT>(value);
+  }
+}
+/*****************************************************************************/
+template <class OT>
+void convertSlice(const void* source, OT* destination, std::size_t count,
+                  const MappedPixelReader::PixelFormat& format) {
+  if (format.bits_allocated == 8) {
+    convertPixels(static_cast<const std::uint8_t*>(source), destination,
+                  count, format);
+  } else {
+    convertPixels(static_cast<const std::uint16_t*>(source), destination,
+                  count, format);
+  }
+}
+/*****************************************************************************/
+}  // namespace
+/*****************************************************************************/
+MappedPixelReader::MappedPixelReader(vtkMappedDICOMReader* reader_) {
+  reader = reader_;
+}
+/*****************************************************************************/
+bool MappedPixelReader::canRead() {
+  const std::uint16_t probe = 1;
+  unsigned char first_byte = 0;
+  std::memcpy(&first_byte, &probe, 1);
+  if (first_byte != 1) {
+    return false;
+  }
+
+  vtkIntArray* file_indices = reader->GetFileIndexArray();
+  if (file_indices->GetNumberOfComponents() != 1) {
+    return false;
+  }
+  vtkDICOMMetaData* meta = reader->GetMetaData();
+  formats.resize(meta->GetNumberOfInstances());
+  for (int i = 0; i != meta->GetNumberOfInstances(); ++i) {
+    if (!checkFile(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> MappedPixelReader::read() {
+  vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+  output->SetExtent(reader->GetDataExtent());
+  output->SetSpacing(reader->GetDataSpacing());
+  output->SetOrigin(reader->GetDataOrigin());
+  output->AllocateScalars(reader->GetDataScalarType(), 1);
+
+  int dims[3];
+  output->GetDimensions(dims);
+  std::size_t pixel_count = static_cast<std::size_t>(dims[0]) * dims[1];
+  std::size_t slice_size = pixel_count * output->GetScalarSize();
+  unsigned char* data = static_cast<unsigned char*>(output->GetScalarPointer());
+
+  std::atomic<bool> failed(false);
+  vtkSMPTools::For(0, dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType slice = begin; slice != end && !failed; ++slice) {
+      if (!copySlice(static_cast<int>(slice), data + slice * slice_size,
+                     pixel_count)) {
+        failed = true;
+      }
+    }
+  });
+  if (failed) {
+    return nullptr;
+  }
+  return output;
+}
+/*****************************************************************************/
+bool MappedPixelReader::checkFile(int file_index) {
+  vtkDICOMMetaData* meta = reader->GetMetaData();
+  std::string syntax =
+      meta->Get(file_index, DicomTags::transfer_syntax_tag).AsString();
+  if (syntax != "1.2.840.10008.1.2" && syntax != "1.2.840.10008.1.2.1") {
+    return false;
+  }
+  if (meta->Get(file_index, DicomTags::samples_tag).AsInt() != 1) {
+    return false;
+  }
+  vtkDICOMValue frames = meta->Get(file_index, DicomTags::frames_tag);
+  if (frames.IsValid() && frames.AsInt() > 1) {
+    return false;
+  }
+
+  PixelFormat& format = formats[file_index];
+  format.bits_allocated =
+      meta->Get(file_index, DicomTags::bits_allocated_tag).AsInt();
+  format.bits_stored =
+      meta->Get(file_index, DicomTags::bits_stored_tag).AsInt();
+  format.is_signed =
+      meta->Get(file_index, DicomTags::pixel_representation_tag).AsInt() == 1;
+  if (format.bits_allocated != 8 && format.bits_allocated != 16) {
+    return false;
+  }
+  if (format.bits_stored < 1 || format.bits_stored > format.bits_allocated) {
+    return false;
+  }
+  vtkDICOMValue high_bit = meta->Get(file_index, DicomTags::high_bit_tag);
+  if (high_bit.IsValid() && high_bit.AsInt() != format.bits_stored - 1) {
+    return false;
+  }
+
+  format.slope = 1.0;
+  format.intercept = 0.0;
+  vtkDICOMValue slope = meta->Get(file_index, DicomTags::rescale_slope_tag);
+  vtkDICOMValue intercept =
+      meta->Get(file_index, DicomTags::rescale_intercept_tag);
+  if (reader->GetAutoRescale()) {
+    if (slope.IsValid()) {
+      format.slope = slope.AsDouble();
+    }
+    if (intercept.IsValid()) {
+      format.intercept = intercept.AsDouble();
+    }
+  } else if (file_index != 0) {
+    // Без AutoRescale vtkDICOMReader приводит срезы к slope/intercept
+    // первого файла, такие серии оставляем ему
+    vtkDICOMValue first_slope = meta->Get(0, DicomTags::rescale_slope_tag);
+    vtkDICOMValue first_intercept =
+        meta->Get(0, DicomTags::rescale_intercept_tag);
+    if (slope.AsDouble() != first_slope.AsDouble() ||
+        intercept.AsDouble() != first_intercept.AsDouble()) {
+      return false;
+    }
+  }
+  return true;
+}
+/*****************************************************************************/
+bool MappedPixelReader::isRawCopy(const PixelFormat& format) const {
+  int file_type = VTK_VOID;
+  if (format.bits_allocated == 8) {
+    file_type = format.is_signed ? VTK_SIGNED_CHAR : VTK_UNSIGNED_CHAR;
+  } else {
+    file_type = format.is_signed ? VTK_SHORT : VTK_UNSIGNED_SHORT;
+  }
+  return file_type == reader->GetDataScalarType() &&
+         format.bits_stored == format.bits_allocated &&
+         format.slope == 1.0 && format.intercept == 0.0;
+}
+/*****************************************************************************/
+bool MappedPixelReader::copySlice(int slice, void* destination,
+                                  std::size_t pixel_count) {
+  int file_index = reader->GetFileIndexArray()->GetValue(slice);
+  const PixelFormat& format = formats[file_index];
+  std::size_t slice_size = pixel_count * (format.bits_allocated / 8);
+  const char* filename = reader->GetFileNames()->GetValue(file_index).c_str();
+  vtkTypeInt64 offset = reader->getPixelDataOffset(file_index);
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || offset <= 0 ||
+      offset % (format.bits_allocated / 8) != 0 ||
+      static_cast<std::size_t>(offset) + slice_size >
+          static_cast<std::size_t>(info.st_size)) {
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+  const void* pixels = static_cast<unsigned char*>(mapping) + offset;
+  if (isRawCopy(format)) {
+    std::memcpy(destination, pixels, slice_size);
+  } else {
+    // Тип результата выбран vtkDICOMReader с учётом пересчёта
+    switch (reader->GetDataScalarType()) {
+      vtkTemplateMacro(convertSlice(
+          pixels, static_cast<VTK_TT*>(destination), pixel_count, format));
+    }
+  }
+  munmap(mapping, info.st_size);
+  return true;
+}
+/*****************************************************************************/
@@ -0,0 +1,57 @@
+#ifndef MAPPED_PIXEL_READER
+#define MAPPED_PIXEL_READER
+
+#include <vtkDICOMReader.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+/*****************************************************************************/
+// vtkDICOMReader уже знает смещение PixelData каждого файла после
+// UpdateInformation, наследник лишь открывает к нему доступ
+class vtkMappedDICOMReader : public vtkDICOMReader {
+ public:
+  static vtkMappedDICOMReader* New();
+  vtkTypeMacro(vtkMappedDICOMReader, vtkDICOMReader);
+  vtkTypeInt64 getPixelDataOffset(int file_index);
+
+ protected:
+  vtkMappedDICOMReader() = default;
+  ~vtkMappedDICOMReader() override = default;
+
+ private:
+  vtkMappedDICOMReader(const vtkMappedDICOMReader&) = delete;
+  void operator=(const vtkMappedDICOMReader&) = delete;
+};
+/*****************************************************************************/
+class MappedPixelReader {
+ public:
+  explicit MappedPixelReader(vtkMappedDICOMReader* reader_);
+
+ public:
+  // Только несжатый little-endian, иначе читает обычный vtkDICOMReader.
+  // Маска bits_stored и пересчёт slope/intercept выполняются при копировании
+  bool canRead();
+  vtkSmartPointer<vtkImageData> read();
+
+ public:
+  struct PixelFormat {
+    int bits_allocated;
+    int bits_stored;
+    bool is_signed;
+    double slope;
+    double intercept;
+  };
+
+ private:
+  bool checkFile(int file_index);
+  bool copySlice(int slice, void* destination, std::size_t pixel_count);
+  bool isRawCopy(const PixelFormat& format) const;
+
+ private:
+  vtkMappedDICOMReader* reader;
+  std::vector<PixelFormat> formats;
+};
+/*****************************************************************************/
+#endif  // MAPPED_PIXEL_READER
@@ -0,0 +1,135 @@
+#include "mesh_smoother.h"
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+/*****************************************************************************/
+MeshSmoother::MeshSmoother(int iterations_, double pass_band_) {
+  if (iterations_ < 0) {
+    throw std::runtime_error("Number of smoothing iterations is negative");
+  }
+  if (pass_band_ <= 0 || pass_band_ >= 1) {
+    throw std::runtime_error("Pass band must be in (0, 1)");
+  }
+  iterations = iterations_;
+  pass_band = pass_band_;
+  // 1 / lambda + 1 / mu = pass_band
+  lambda = 0.5;
+  mu = 1.0 / (pass_band - 1.0 / lambda);
+}
+/*****************************************************************************/
+MeshSmoother MeshSmoother::fromGaussParameters(double gauss_radius,
+                                               double gauss_deviation) {
+  int iterations = static_cast<int>(std::lround(gauss_radius * 4));
+  double pass_band =
+      std::clamp(0.2 / std::max(gauss_deviation, 1e-3), 0.01, 0.2);
+  return MeshSmoother(std::max(iterations, 0), pass_band);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> MeshSmoother::smooth(vtkPolyData* input) const {
+  vtkIdType number_of_points = input->GetNumberOfPoints();
+  std::vector<double> current(3 * number_of_points);
+  for (vtkIdType i = 0; i != number_of_points; ++i) {
+    input->GetPoint(i, &current[3 * i]);
+  }
+
+  std::vector<vtkIdType> offsets;
+  std::vector<vtkIdType> neighbours;
+  buildNeighbours(input, offsets, neighbours);
+
+  std::vector<double> next(current.size());
+  for (int i = 0; i != iterations; ++i) {
+    applyStep(lambda, offsets, neighbours, current, next);
+    current.swap(next);
+    applyStep(mu, offsets, neighbours, current, next);
+    current.swap(next);
+  }
+
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(number_of_points);
+  for (vtkIdType i = 0; i != number_of_points; ++i) {
+    points->SetPoint(i, &current[3 * i]);
+  }
+
+  vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+  output->ShallowCopy(input);
+  output->SetPoints(points);
+  // Нормали входа после сдвига вершин неверны
+  if (vtkDataArray* normals = output->GetPointData()->GetNormals()) {
+    output->GetPointData()->RemoveArray(normals->GetName());
+  }
+  return output;
+}
+/*****************************************************************************/
+int MeshSmoother::getIterations() const { return iterations; }
+/*****************************************************************************/
+double MeshSmoother::getPassBand() const { return pass_band; }
+/*****************************************************************************/
+void MeshSmoother::buildNeighbours(vtkPolyData* input,
+                                   std::vector<vtkIdType>& offsets,
+                                   std::vector<vtkIdType>& neighbours) const {
+  // Соседи вершины - концы рёбер полигонов, в виде сжатых строк
+  std::vector<std::pair<vtkIdType, vtkIdType>> edges;
+  vtkCellArray* polys = input->GetPolys();
+  vtkNew<vtkIdList> cell;
+  polys->InitTraversal();
+  while (polys->GetNextCell(cell)) {
+    vtkIdType size = cell->GetNumberOfIds();
+    for (vtkIdType i = 0; i != size; ++i) {
+      vtkIdType a = cell->GetId(i);
+      vtkIdType b = cell->GetId((i + 1) % size);
+      edges.emplace_back(a, b);
+      edges.emplace_back(b, a);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  offsets.assign(input->GetNumberOfPoints() + 1, 0);
+  neighbours.resize(edges.size());
+  for (std::size_t i = 0; i != edges.size(); ++i) {
+    ++offsets[edges[i].first + 1];
+    neighbours[i] = edges[i].second;
+  }
+  for (std::size_t i = 1; i != offsets.size(); ++i) {
+    offsets[i] += offsets[i - 1];
+  }
+}
+/*****************************************************************************/
+void MeshSmoother::applyStep(double factor,
+                             const std::vector<vtkIdType>& offsets,
+                             const std::vector<vtkIdType>& neighbours,
+                             const std::vector<double>& current,
+                             std::vector<double>& next) const {
+  vtkIdType number_of_points = static_cast<vtkIdType>(offsets.size()) - 1;
+  vtkSMPTools::For(0, number_of_points, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType i = begin; i != end; ++i) {
+      vtkIdType count = offsets[i + 1] - offsets[i];
+      for (int axis = 0; axis != 3; ++axis) {
+        double value = current[3 * i + axis];
+        if (count == 0) {
+          next[3 * i + axis] = value;
+          continue;
+        }
+        // Равномерный лапласиан: сдвиг к центру масс соседей
+        double mean = 0;
+        for (vtkIdType n = offsets[i]; n != offsets[i + 1]; ++n) {
+          mean += current[3 * neighbours[n] + axis];
+        }
+        mean /= static_cast<double>(count);
+        next[3 * i + axis] = value + factor * (mean - value);
+      }
+    }
+  });
+}
+/*****************************************************************************/
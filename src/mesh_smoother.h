@@ -0,0 +1,43 @@
+#ifndef MESH_SMOOTHER
+#define MESH_SMOOTHER
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+/*****************************************************************************/
+class MeshSmoother {
+ public:
+  // Сглаживание Таубина: чередование шагов lambda и mu почти не сжимает
+  // поверхность. pass_band - доля сохраняемых частот, чем меньше, тем
+  // сильнее сглаживание
+  MeshSmoother(int iterations_, double pass_band_);
+
+ public:
+  // Параметры объёмного гаусса переводятся в параметры сглаживания сетки:
+  // радиус - в число итераций, отклонение - в полосу пропускания
+  static MeshSmoother fromGaussParameters(double gauss_radius,
+                                          double gauss_deviation);
+  // Стоимость линейна по числу вершин, вершины обрабатываются параллельно.
+  // Нормали входа на выходе не сохраняются
+  vtkSmartPointer<vtkPolyData> smooth(vtkPolyData* input) const;
+  int getIterations() const;
+  double getPassBand() const;
+
+ private:
+  void buildNeighbours(vtkPolyData* input, std::vector<vtkIdType>& offsets,
+                       std::vector<vtkIdType>& neighbours) const;
+  void applyStep(double factor, const std::vector<vtkIdType>& offsets,
+                 const std::vector<vtkIdType>& neighbours,
+                 const std::vector<double>& current,
+                 std::vector<double>& next) const;
+
+ private:
+  int iterations;
+  double pass_band;
+  double lambda;
+  double mu;
+};
+/*****************************************************************************/
+#endif  // MESH_SMOOTHER
@@ -1,127 +1,211 @@
 #include "model_builder.h"
 
+#include <vtkAppendPolyData.h>
 #include <vtkCleanPolyData.h>
-#include <vtkFlyingEdges3D.h>
+#include <vtkDiscreteFlyingEdges3D.h>
+#include <vtkExtractVOI.h>
+#include <vtkGeometryFilter.h>
+#include <vtkHausdorffDistancePointSetFilter.h>
 #include <vtkHull.h>
-#include <vtkImageGaussianSmooth.h>
 #include <vtkImageOpenClose3D.h>
-#include <vtkImageThreshold.h>
 #include <vtkPLYWriter.h>
 #include <vtkPointData.h>
-#include <vtkPolyDataConnectivityFilter.h>
+#include <vtkSMPTools.h>
 #include <vtkSTLWriter.h>
+#include <vtkThreshold.h>
+#include <vtkTypeTraits.h>
+#include <vtkVersionMacros.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
 
-#include "config_reader.h"
-#include "scene_provider.h"
+#include "recursive_gaussian.h"
+#include "separable_gaussian.h"
+#include "surface_extraction.h"
 
 /*****************************************************************************/
-void vtkButtonCallback::Execute(vtkObject* caller, unsigned long, void*) {
-  parent->buttonEvent(this);
+namespace {
+template <typename T>
+void thresholdVoxels(const T* in, T* out, vtkIdType slice_size, int slices,
+                     double lower, double in_value, double out_value) {
+  // Как в vtkImageThreshold: значения вне диапазона типа обрезаются
+  double type_min = vtkTypeTraits<T>::Min();
+  double type_max = vtkTypeTraits<T>::Max();
+  T in_scalar = static_cast<T>(std::clamp(in_value, type_min, type_max));
+  T out_scalar = static_cast<T>(std::clamp(out_value, type_min, type_max));
+  vtkSMPTools::For(0, slices, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType idx = begin * slice_size; idx != end * slice_size; ++idx) {
+      out[idx] = static_cast<double>(in[idx]) <= lower ? in_scalar : out_scalar;
+    }
+  });
 }
 /*****************************************************************************/
-vtkButtonCallback::vtkButtonCallback() {}
-/*****************************************************************************/
-void vtkButtonCallback::setParent(ModelBuilder* parent) {
-  this->parent = parent;
-}
-/*****************************************************************************/
-void vtkSliderCallback::Execute(vtkObject* caller, unsigned long, void*) {
-  vtkSliderWidget* sliderWidget = reinterpret_cast<vtkSliderWidget*>(caller);
-  double value =
-      static_cast<vtkSliderRepresentation*>(sliderWidget->GetRepresentation())
-          ->GetValue();
-  parent->sliderEvent(this, value);
+// Свёртка слоя с ядром вдоль нормали в один срез. Ядро у границы объёма
+// обрезается и перенормируется, как в SeparableGaussian
+template <typename T>
+void collapseSlab(const T* in, float* out, const int* dims, int axis,
+                  int center, const std::vector<double>& kernel) {
+  vtkIdType strides[3] = {1, dims[0],
+                          static_cast<vtkIdType>(dims[0]) * dims[1]};
+  int plane_dims[3] = {dims[0], dims[1], dims[2]};
+  plane_dims[axis] = 1;
+  int half_width = static_cast<int>(kernel.size() / 2);
+  int first = std::max(center - half_width, 0);
+  int last = std::min(center + half_width, dims[axis] - 1);
+  double weight = 0;
+  for (int k = first; k <= last; ++k) {
+    weight += kernel[k - center + half_width];
+  }
+
+  vtkSMPTools::For(0, plane_dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z != end; ++z) {
+      for (int y = 0; y != plane_dims[1]; ++y) {
+        float* row = out + (z * plane_dims[1] + y) * plane_dims[0];
+        for (int x = 0; x != plane_dims[0]; ++x) {
+          vtkIdType base = x * strides[0] + y * strides[1] + z * strides[2];
+          double sum = 0;
+          for (int k = first; k <= last; ++k) {
+            sum += kernel[k - center + half_width] *
+                   static_cast<double>(in[base + k * strides[axis]]);
+          }
+          row[x] = static_cast<float>(sum / weight);
+        }
+      }
+    }
+  });
 }
 /*****************************************************************************/
-vtkSliderCallback::vtkSliderCallback() {}
-/*****************************************************************************/
-void vtkSliderCallback::setParent(ModelBuilder* parent) {
-  this->parent = parent;
+void convolveAxis(float* data, const int* dims, int axis,
+                  const std::vector<double>& kernel) {
+  vtkIdType strides[3] = {1, dims[0],
+                          static_cast<vtkIdType>(dims[0]) * dims[1]};
+  int half_width = static_cast<int>(kernel.size() / 2);
+  int length = dims[axis];
+  int other[2] = {(axis + 1) % 3, (axis + 2) % 3};
+  vtkSMPTools::For(0, dims[other[1]], [&](vtkIdType begin, vtkIdType end) {
+    std::vector<float> line(length);
+    for (vtkIdType j = begin; j != end; ++j) {
+      for (int i = 0; i != dims[other[0]]; ++i) {
+        float* start = data + i * strides[other[0]] + j * strides[other[1]];
+        for (int n = 0; n != length; ++n) {
+          line[n] = start[n * strides[axis]];
+        }
+        for (int n = 0; n != length; ++n) {
+          double sum = 0;
+          double weight = 0;
+          for (int k = std::max(n - half_width, 0);
+               k <= std::min(n + half_width, length - 1); ++k) {
+            sum += kernel[k - n + half_width] * line[k];
+            weight += kernel[k - n + half_width];
+          }
+          start[n * strides[axis]] = static_cast<float>(sum / weight);
+        }
+      }
+    }
+  });
 }
+}  // namespace
 /*****************************************************************************/
-ModelBuilder::ModelBuilder(vtkSmartPointer<vtkImageData> image_data_) {
-  image_data = image_data_;
+ModelBuilder::ModelBuilder(vtkSmartPointer<vtkImageData> image_data_,
+                           const std::string& volume_key_,
+                           const BuildOptions& options_) {
+  image_data = vtkSmartPointer<vtkImageData>::New();
+  image_data->ShallowCopy(image_data_);
+  image_data->GetExtent(volume_extent);
+  volume_key = volume_key_;
+  options = options_;
   initHistogram();
-  initCallbacks();
   initParameters();
+  initCache();
+  initBufferPool();
+  initCompression();
   buildModel();
 }
 /*****************************************************************************/
-void ModelBuilder::buttonEvent(vtkSmartPointer<vtkButtonCallback> button) {
-  if (button == build_button_callback) {
-    buildModel();
-    SceneProvider::getInstance()->setPolyData(model);
-  } else if (button == save_button_callback) {
-    saveModel();
-  }
-}
-/*****************************************************************************/
-void ModelBuilder::sliderEvent(vtkSmartPointer<vtkSliderCallback> slider,
-                               double value) {
-  if (slider == radius_slider_callback) {
-    setGaussRadius(value);
-  } else if (slider == morph_slider_callback) {
-    setMorphRadius(value);
-  } else if (slider == deviation_slider_callback) {
-    setGaussDeviation(value);
-  } else if (slider == threshold_slider_callback) {
-    setTreshold(value);
-  }
-}
+double ModelBuilder::getUpperScalarRange() { return scalar_range[1]; }
 /*****************************************************************************/
-vtkSmartPointer<vtkButtonCallback> ModelBuilder::getBuildButtonCallback()
-    const {
-  return build_button_callback;
-}
+double ModelBuilder::getLowerScalarRange() { return scalar_range[0]; }
 /*****************************************************************************/
-vtkSmartPointer<vtkButtonCallback> ModelBuilder::getSaveButtonCallback() const {
-  return save_button_callback;
-}
+vtkSmartPointer<vtkPolyData> ModelBuilder::getModel() { return model; }
 /*****************************************************************************/
-vtkSmartPointer<vtkSliderCallback> ModelBuilder::getRadiusSliderCallback()
-    const {
-  return radius_slider_callback;
+vtkSmartPointer<vtkPolyData> ModelBuilder::getLabelModel(std::size_t index) {
+  return label_models.at(index);
 }
 /*****************************************************************************/
-vtkSmartPointer<vtkSliderCallback> ModelBuilder::getThresholdSliderCallback()
-    const {
-  return threshold_slider_callback;
+std::size_t ModelBuilder::getNumberOfLabelModels() const {
+  return label_models.size();
 }
 /*****************************************************************************/
-vtkSmartPointer<vtkSliderCallback> ModelBuilder::getMorphSliderCallback()
-    const {
-  return morph_slider_callback;
+vtkSmartPointer<vtkImageHistogram> ModelBuilder::getHistogram() {
+  return histogram;
 }
 /*****************************************************************************/
-vtkSmartPointer<vtkSliderCallback> ModelBuilder::getDeviationSliderCallback()
-    const {
-  return deviation_slider_callback;
+const BufferPool* ModelBuilder::getBufferPool() const {
+  return buffer_pool.get();
 }
 /*****************************************************************************/
-double ModelBuilder::getUpperScalarRange() {
-  return image_data->GetScalarRange()[1];
+void ModelBuilder::getVolumeExtent(int* extent) const {
+  std::copy(volume_extent, volume_extent + 6, extent);
 }
 /*****************************************************************************/
-double ModelBuilder::getLowerScalarRange() {
-  return image_data->GetScalarRange()[0];
+vtkSmartPointer<vtkImageData> ModelBuilder::getSourceSlice(int axis,
+                                                           int index) {
+  int slice_extent[6];
+  getSlabExtent(axis, index, 0, slice_extent);
+  return extractSourceVOI(slice_extent);
 }
 /*****************************************************************************/
-vtkSmartPointer<vtkPolyData> ModelBuilder::getModel() { return model; }
-/*****************************************************************************/
-vtkSmartPointer<vtkImageHistogram> ModelBuilder::getHistogram() {
-  return histogram;
+vtkSmartPointer<vtkImageData> ModelBuilder::getPreviewSlice(int axis,
+                                                            int index) {
+  // Ядро сепарабельно и линейно: слой маски сначала сворачивается вдоль
+  // нормали в один срез, затем срез сглаживается только в своей плоскости.
+  // Результат тот же, что у объёмного сглаживания слоя, но без 3D прохода
+  std::vector<double> kernel = getPreviewKernel();
+  int half_width = static_cast<int>(kernel.size() / 2);
+  int slab_extent[6];
+  getSlabExtent(axis, index, half_width, slab_extent);
+  PooledImage slab(buffer_pool.get(), extractSourceVOI(slab_extent));
+  PooledImage mask(buffer_pool.get(), thresholdImage(slab.get()));
+
+  int slice_extent[6];
+  getSlabExtent(axis, index, 0, slice_extent);
+  vtkSmartPointer<vtkImageData> slice = BufferPool::allocateImage(
+      nullptr, slice_extent, mask.get()->GetOrigin(),
+      mask.get()->GetSpacing(), VTK_FLOAT);
+  float* data = static_cast<float*>(slice->GetScalarPointer());
+  int slab_dims[3];
+  mask.get()->GetDimensions(slab_dims);
+  int center = index - slab_extent[2 * axis];
+  switch (mask.get()->GetScalarType()) {
+    vtkTemplateMacro(collapseSlab(
+        static_cast<const VTK_TT*>(mask.get()->GetScalarPointer()), data,
+        slab_dims, axis, center, kernel));
+    default:
+      throw std::runtime_error("Unsupported scalar type for preview");
+  }
+
+  int slice_dims[3];
+  slice->GetDimensions(slice_dims);
+  for (int in_plane = 0; in_plane != 3; ++in_plane) {
+    if (in_plane != axis) {
+      convolveAxis(data, slice_dims, in_plane, kernel);
+    }
+  }
+  return slice;
 }
 /*****************************************************************************/
 void ModelBuilder::initHistogram() {
   // Некоторая инфа о vtkImageData, на основе которого строится гистограмма
-  double range[2];
   int dims[3];
-  image_data->GetScalarRange(range);
+  image_data->GetScalarRange(scalar_range);
   image_data->GetDimensions(dims);
-  std::cout << "scalar range: " << "[" << range[0] << ", " << range[1] << "]"
-            << std::endl;
+  std::cout << "scalar range: " << "[" << scalar_range[0] << ", "
+            << scalar_range[1] << "]" << std::endl;
   std::cout << "dims: " << dims[0] << ", " << dims[1] << ", " << dims[2]
             << std::endl;
   std::cout << "points: " << image_data->GetNumberOfPoints() << std::endl;
@@ -150,83 +234,138 @@ void ModelBuilder::initHistogram() {
   std::cout << std::endl;
 }
 /*****************************************************************************/
-void ModelBuilder::initCallbacks() {
-  save_button_callback = vtkSmartPointer<vtkButtonCallback>::New();
-  build_button_callback = vtkSmartPointer<vtkButtonCallback>::New();
-  morph_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
-  radius_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
-  deviation_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
-  threshold_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
-
-  save_button_callback->setParent(this);
-  build_button_callback->setParent(this);
-  morph_slider_callback->setParent(this);
-  radius_slider_callback->setParent(this);
-  deviation_slider_callback->setParent(this);
-  threshold_slider_callback->setParent(this);
+void ModelBuilder::initParameters() {
+  morph_radius = options.morph_radius;
+  gauss_radius = options.gauss_radius;
+  gauss_deviation = options.gauss_deviation;
+  threshold = options.threshold;
+  smoothing_mode = options.smoothing_mode;
+  labels = options.labels;
 }
 /*****************************************************************************/
-void ModelBuilder::initParameters() {
+void ModelBuilder::initCache() {
+  // Кэш не обязателен: без cache_path модель всегда строится заново
+  if (options.cache_path.empty()) {
+    return;
+  }
   try {
-    morph_radius = ConfigReader::getInstance()->getMorphRadius();
-    gauss_radius = ConfigReader::getInstance()->getGaussRadius();
-    gauss_deviation = ConfigReader::getInstance()->getGaussDeviation();
-    threshold = ConfigReader::getInstance()->getThreshold();
-  } catch (const std::exception& e) {
-    std::cout << "Exception while initParameters()" << e.what() << std::endl;
-    morph_radius = 5;
-    gauss_radius = 5;
-    gauss_deviation = 2;
-    threshold = 13;
+    cache = std::make_unique<ModelCache>(
+        options.cache_path,
+        static_cast<std::uintmax_t>(options.cache_size_mb * 1024 * 1024));
+  } catch (const std::exception& ex) {
+    std::cout << "Model cache disabled: " << ex.what() << std::endl;
+    cache.reset();
   }
 }
 /*****************************************************************************/
-void ModelBuilder::saveModel() {
-  std::string folder;
-  std::string name;
-  try {
-    folder = ConfigReader::getInstance()->getModelPath();
-    name = ConfigReader::getInstance()->getModelName();
-  } catch (const std::exception& ex) {
-    std::cout << ex.what() << std::endl;
+void ModelBuilder::initCompression() {
+  if (!options.compress_volume) {
+    return;
+  }
+
+  // Гистограмма уже посчитана, её изображение остаётся в выходе фильтра.
+  // После сжатия несжатый объём больше не держим
+  compressed_volume = std::make_unique<CompressedVolume>(image_data);
+  histogram->RemoveAllInputConnections(0);
+  image_data = nullptr;
+}
+/*****************************************************************************/
+void ModelBuilder::initBufferPool() {
+  // Промежуточные объёмы одной сборки переиспользуются следующей, чтобы не
+  // платить за выделение и первые обращения к страницам на каждой пересборке
+  if (options.buffer_pool_mb <= 0) {
+    return;
+  }
+  // Пул держит полноразмерную маску между сборками, а сжатие объёма нужно
+  // как раз для того, чтобы несжатых полных объёмов в памяти не было
+  if (options.compress_volume) {
+    std::cout << "Buffer pool disabled with compress_volume" << std::endl;
+    return;
+  }
+  buffer_pool = std::make_unique<BufferPool>(
+      static_cast<std::size_t>(options.buffer_pool_mb * 1024 * 1024));
+}
+/*****************************************************************************/
+void ModelBuilder::printBufferPoolStats() const {
+  if (!buffer_pool) {
     return;
   }
+  std::size_t requests = buffer_pool->getRequests();
+  std::size_t hits = buffer_pool->getHits();
+  std::cout << "buffer pool hits: " << hits << " / " << requests
+            << ", pooled: " << buffer_pool->getPooledBytes() / (1024 * 1024)
+            << " MB" << std::endl;
+}
+/*****************************************************************************/
+void ModelBuilder::saveModel() {
+  std::string folder = options.model_path;
+  std::string name = options.model_name;
 
   if (!std::filesystem::exists(folder)) {
     std::cout << "Directory " << folder << " not exists" << std::endl;
     return;
   }
 
-  std::string filepath = folder + "/" + name + ".ply";
+  if (label_models.empty()) {
+    writeModel(model, folder + "/" + name);
+    return;
+  }
+  // Метки могут прийти не из конфига, имена проверяются до записи.
+  // Вызывается из интерфейса, поэтому, как и с каталогом, без исключения
+  for (const LabelRange& label : labels) {
+    if (!LabelClassifier::isValidName(label.name)) {
+      std::cout << "Invalid label name for a model file: " << label.name
+                << std::endl;
+      return;
+    }
+  }
+  for (std::size_t i = 0; i != label_models.size(); ++i) {
+    writeModel(label_models[i], folder + "/" + name + "_" + labels[i].name);
+  }
+}
+/*****************************************************************************/
+void ModelBuilder::writeModel(vtkSmartPointer<vtkPolyData> polydata,
+                              const std::string& filepath) {
+  std::string filepath_ply = filepath + ".ply";
   vtkNew<vtkPLYWriter> writer;
-  writer->SetFileName(filepath.c_str());
-  writer->SetInputData(model);
+  writer->SetFileName(filepath_ply.c_str());
+  writer->SetInputData(polydata);
   writer->Update();
 
-  std::string filepath_stl = folder + "/" + name + ".stl";
+  std::string filepath_stl = filepath + ".stl";
   vtkNew<vtkSTLWriter> writer_stl;
   writer_stl->SetFileName(filepath_stl.c_str());
-  writer_stl->SetInputData(model);
+  writer_stl->SetInputData(polydata);
   writer_stl->Update();
 }
 /*****************************************************************************/
 void ModelBuilder::buildModel() {
+  if (loadCachedModel()) {
+    return;
+  }
+  if (labels.empty()) {
+    buildSurfaceModel();
+  } else {
+    buildLabelModels();
+  }
+  if (buffer_pool) {
+    buffer_pool->trim();
+  }
+  printBufferPoolStats();
+  storeCachedModel();
+}
+/*****************************************************************************/
+void ModelBuilder::buildSurfaceModel() {
+  label_models.clear();
   model = vtkSmartPointer<vtkPolyData>::New();
 
-  vtkNew<vtkImageData> data;
-  data->DeepCopy(image_data);
-
-  vtkNew<vtkImageThreshold> thresh_filter;
-  thresh_filter->SetInputData(data);
-  thresh_filter->ThresholdByLower(threshold);
-  thresh_filter->SetInValue(1024);
-  thresh_filter->SetOutValue(0);
-  thresh_filter->Update();
+  // Объёмы уходят обратно в пул при выходе из функции, в том числе ранних
+  PooledImage mask(buffer_pool.get(), thresholdVolume());
 
   // Вроде и полезнео, но профита не вижу. Аккуратно, модель может уезжать от
   // таких движений
   // vtkNew<vtkImageOpenClose3D> morph_open;
-  // morph_open->SetInputData(thresh_filter->GetOutput());
+  // morph_open->SetInputData(mask);
   // morph_open->SetOpenValue(1024);
   // morph_open->SetCloseValue(0);
   // morph_open->SetKernelSize(morph_radius, morph_radius, morph_radius);
@@ -239,40 +378,274 @@ void ModelBuilder::buildModel() {
   // morph_close->SetKernelSize(morph_radius, morph_radius, morph_radius);
   // morph_close->Update();
 
-  vtkNew<vtkImageGaussianSmooth> gauss;
-  gauss->SetInputData(thresh_filter->GetOutput());
-  gauss->SetDimensionality(3);
-  gauss->SetRadiusFactor(gauss_radius);
-  gauss->SetStandardDeviation(gauss_deviation);
-  gauss->Update();
-
-  vtkNew<vtkFlyingEdges3D> flying_edges;
-  flying_edges->SetInputData(gauss->GetOutput());
-  flying_edges->ComputeNormalsOn();
-  flying_edges->ComputeScalarsOff();
-  flying_edges->SetValue(0, 512);
-  flying_edges->Update();
-
-  vtkNew<vtkPolyDataConnectivityFilter> confilter;
-  confilter->SetInputData(flying_edges->GetOutput());
-  confilter->SetExtractionModeToLargestRegion();
-  confilter->Update();
-
-  vtkNew<vtkCleanPolyData> cleaner;
-  cleaner->SetInputData(confilter->GetOutput());
-  cleaner->Update();
+  bool mesh_smoothing = smoothing_mode == "mesh";
+  auto start = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkPolyData> surface =
+      extractSurface(mask.get(), mesh_smoothing);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "surface extraction: " << elapsed.count() << " ms"
+            << std::endl;
+  if (!surface) {
+    return;
+  }
+  if (options.benchmark_smoothing) {
+    benchmarkSmoothing(mask.get(), surface, mesh_smoothing);
+  }
 
+  // Выпуклая оболочка из плоскостей сферы определяет итоговую модель почти
+  // целиком: разница между режимами сглаживания в ней стирается, поэтому
+  // сравнение режимов идёт по поверхности до оболочки
   vtkNew<vtkHull> convex_hull;
-  convex_hull->SetInputConnection(cleaner->GetOutputPort());
+  convex_hull->SetInputData(surface);
   convex_hull->AddCubeFacePlanes();
   convex_hull->AddRecursiveSpherePlanes(5);
   convex_hull->Update();
 
   model = convex_hull->GetOutput();
-  // model = cleaner->GetOutput();
+  // model = surface;
   std::cout << model->GetNumberOfPolys() << std::endl;
 }
 /*****************************************************************************/
+vtkSmartPointer<vtkPolyData> ModelBuilder::extractSurface(
+    vtkImageData* mask, bool mesh_smoothing) {
+  if (mesh_smoothing) {
+    return extractMeshSmoothedSurface(mask, gauss_radius, gauss_deviation);
+  }
+  // Режим mesh сравнивается с объёмным сглаживанием через fir
+  std::string mode = smoothing_mode == "iir" ? "iir" : "fir";
+  return extractVolumeSmoothedSurface(mask, mode, gauss_radius,
+                                      gauss_deviation, buffer_pool.get());
+}
+/*****************************************************************************/
+void ModelBuilder::benchmarkSmoothing(vtkImageData* mask,
+                                      vtkPolyData* surface,
+                                      bool mesh_smoothing) {
+  // Та же маска через другой конвейер: время и расхождение поверхностей.
+  // Для режима mesh сравнение идёт с объёмным гауссом (fir)
+  // Воспроизводимый замер на синтетическом шаре - в тестах
+  auto start = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkPolyData> reference =
+      extractSurface(mask, !mesh_smoothing);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "benchmark " << (mesh_smoothing ? "volume" : "mesh")
+            << " surface extraction: " << elapsed.count() << " ms"
+            << std::endl;
+  if (!reference) {
+    return;
+  }
+
+  vtkNew<vtkHausdorffDistancePointSetFilter> hausdorff;
+  hausdorff->SetInputData(0, surface);
+  hausdorff->SetInputData(1, reference);
+  hausdorff->SetTargetDistanceMethodToPointToCell();
+  hausdorff->Update();
+  double* relative = hausdorff->GetRelativeDistance();
+  std::cout << "hausdorff distance: " << hausdorff->GetHausdorffDistance()
+            << " (" << relative[0] << " / " << relative[1] << ")"
+            << std::endl;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> ModelBuilder::thresholdVolume() {
+  if (compressed_volume) {
+    return compressed_volume->threshold(threshold, 1024, 0,
+                                        buffer_pool.get());
+  }
+  // Исходный объём только читается, копия не нужна
+  return thresholdImage(image_data);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> ModelBuilder::thresholdImage(
+    vtkImageData* input) {
+  // Вместо vtkImageThreshold: тот же результат, но в буфер из пула
+  int dims[3];
+  input->GetDimensions(dims);
+  vtkSmartPointer<vtkImageData> mask = BufferPool::allocateImage(
+      buffer_pool.get(), input->GetExtent(), input->GetOrigin(),
+      input->GetSpacing(), input->GetScalarType());
+  vtkIdType slice_size = static_cast<vtkIdType>(dims[0]) * dims[1];
+  switch (input->GetScalarType()) {
+    vtkTemplateMacro(thresholdVoxels(
+        static_cast<const VTK_TT*>(input->GetScalarPointer()),
+        static_cast<VTK_TT*>(mask->GetScalarPointer()), slice_size, dims[2],
+        threshold, 1024, 0));
+    default:
+      throw std::runtime_error("Unsupported scalar type for threshold");
+  }
+  return mask;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> ModelBuilder::extractSourceVOI(const int* voi) {
+  if (compressed_volume) {
+    return compressed_volume->extractVOI(voi, buffer_pool.get());
+  }
+  vtkNew<vtkExtractVOI> extract;
+  extract->SetInputData(image_data);
+  extract->SetVOI(voi[0], voi[1], voi[2], voi[3], voi[4], voi[5]);
+  extract->Update();
+  vtkSmartPointer<vtkImageData> output = extract->GetOutput();
+  return output;
+}
+/*****************************************************************************/
+void ModelBuilder::getSlabExtent(int axis, int index, int half_width,
+                                 int* extent) const {
+  std::copy(volume_extent, volume_extent + 6, extent);
+  extent[2 * axis] = std::max(index - half_width, volume_extent[2 * axis]);
+  extent[2 * axis + 1] =
+      std::min(index + half_width, volume_extent[2 * axis + 1]);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> ModelBuilder::getSourceVolume() {
+  if (compressed_volume) {
+    return compressed_volume->decompress();
+  }
+  return image_data;
+}
+/*****************************************************************************/
+std::vector<double> ModelBuilder::getPreviewKernel() const {
+  // fir и mesh - ядро объёмного сглаживания, iir - гаусс до 4 sigma,
+  // которым приближается рекурсивный фильтр
+  if (smoothing_mode != "iir") {
+    return SeparableGaussian(gauss_deviation, gauss_radius).getKernel();
+  }
+  double sigma = gauss_deviation;
+  int half_width = sigma < 0.5 ? 0 : RecursiveGaussian(sigma).getReach();
+  std::vector<double> kernel(2 * half_width + 1, 1.0);
+  for (int i = -half_width; i <= half_width; ++i) {
+    if (half_width > 0) {
+      kernel[i + half_width] = std::exp(-i * i / (2.0 * sigma * sigma));
+    }
+  }
+  return kernel;
+}
+/*****************************************************************************/
+void ModelBuilder::buildLabelModels() {
+  // Все ткани за один проход классификации и одну дискретную экстракцию,
+  // поверхности соседних меток совпадают на общей границе
+  LabelClassifier classifier(labels);
+  PooledImage label_volume(
+      buffer_pool.get(),
+      classifier.classify(getSourceVolume(), buffer_pool.get()));
+
+  vtkNew<vtkDiscreteFlyingEdges3D> discrete_edges;
+  discrete_edges->SetInputData(label_volume.get());
+  discrete_edges->ComputeNormalsOff();
+  discrete_edges->ComputeGradientsOff();
+  discrete_edges->ComputeScalarsOn();
+  for (std::size_t i = 0; i != labels.size(); ++i) {
+    discrete_edges->SetValue(static_cast<int>(i), static_cast<double>(i + 1));
+  }
+  discrete_edges->Update();
+
+  label_models.clear();
+  for (std::size_t i = 0; i != labels.size(); ++i) {
+    vtkNew<vtkThreshold> label_filter;
+    label_filter->SetInputData(discrete_edges->GetOutput());
+    label_filter->SetInputArrayToProcess(
+        0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS,
+        vtkDataSetAttributes::SCALARS);
+#if VTK_MAJOR_VERSION > 9 || (VTK_MAJOR_VERSION == 9 && VTK_MINOR_VERSION >= 1)
+    label_filter->SetLowerThreshold(i + 0.5);
+    label_filter->SetUpperThreshold(i + 1.5);
+    label_filter->SetThresholdFunction(vtkThreshold::THRESHOLD_BETWEEN);
+#else
+    label_filter->ThresholdBetween(i + 0.5, i + 1.5);
+#endif
+
+    vtkNew<vtkGeometryFilter> geometry;
+    geometry->SetInputConnection(label_filter->GetOutputPort());
+
+    vtkNew<vtkCleanPolyData> cleaner;
+    cleaner->SetInputConnection(geometry->GetOutputPort());
+    cleaner->Update();
+
+    vtkSmartPointer<vtkPolyData> label_model = cleaner->GetOutput();
+    std::cout << labels[i].name << ": " << label_model->GetNumberOfPolys()
+              << std::endl;
+    label_models.push_back(label_model);
+  }
+  appendLabelModels();
+}
+/*****************************************************************************/
+void ModelBuilder::appendLabelModels() {
+  vtkNew<vtkAppendPolyData> append;
+  for (const vtkSmartPointer<vtkPolyData>& label_model : label_models) {
+    append->AddInputData(label_model);
+  }
+  append->Update();
+  model = append->GetOutput();
+}
+/*****************************************************************************/
+std::string ModelBuilder::getCacheDescription() const {
+  // Всё, от чего зависит результат: вход, параметры и режимы конвейера
+  std::ostringstream description;
+  description << std::setprecision(17) << "pipeline:1;" << volume_key
+              << ";threshold:" << threshold << ";gauss_radius:" << gauss_radius
+              << ";gauss_deviation:" << gauss_deviation
+              << ";morph_radius:" << morph_radius
+              << ";smoothing_mode:" << smoothing_mode;
+  for (const LabelRange& label : labels) {
+    description << ";label:" << label.name << "[" << label.lower << ","
+                << label.upper << "]";
+  }
+  return description.str();
+}
+/*****************************************************************************/
+bool ModelBuilder::loadCachedModel() {
+  if (!cache) {
+    return false;
+  }
+  std::string description = getCacheDescription();
+  std::vector<vtkSmartPointer<vtkPolyData>> cached_models;
+  bool found = true;
+  try {
+    std::size_t count = labels.empty() ? 1 : labels.size();
+    for (std::size_t i = 0; i != count && found; ++i) {
+      std::string entry = labels.empty()
+                              ? description
+                              : description + ";entry:" + std::to_string(i);
+      vtkSmartPointer<vtkPolyData> cached = cache->load(entry);
+      found = cached != nullptr;
+      cached_models.push_back(cached);
+    }
+  } catch (const std::exception& ex) {
+    std::cout << "Can't read model cache: " << ex.what() << std::endl;
+    return false;
+  }
+
+  if (found && labels.empty()) {
+    label_models.clear();
+    model = cached_models.front();
+  } else if (found) {
+    label_models = cached_models;
+    appendLabelModels();
+  }
+  std::cout << "model cache " << (found ? "hit" : "miss")
+            << ", hits: " << cache->getHits()
+            << ", misses: " << cache->getMisses() << std::endl;
+  return found;
+}
+/*****************************************************************************/
+void ModelBuilder::storeCachedModel() {
+  if (!cache) {
+    return;
+  }
+  try {
+    std::string description = getCacheDescription();
+    if (label_models.empty()) {
+      cache->store(description, model);
+    }
+    for (std::size_t i = 0; i != label_models.size(); ++i) {
+      cache->store(description + ";entry:" + std::to_string(i),
+                   label_models[i]);
+    }
+    cache->evict();
+  } catch (const std::exception& ex) {
+    std::cout << "Can't store model in cache: " << ex.what() << std::endl;
+  }
+}
+/*****************************************************************************/
 void ModelBuilder::setMorphRadius(double value) { morph_radius = value; }
 /*****************************************************************************/
 void ModelBuilder::setGaussRadius(double value) { gauss_radius = value; }
@@ -1,86 +1,97 @@
 #ifndef MODEL_BUILDER
 #define MODEL_BUILDER
 
-#include <vtkCommand.h>
-#include <vtkImageAccumulate.h>
 #include <vtkImageData.h>
 #include <vtkImageHistogram.h>
 #include <vtkPolyData.h>
-#include <vtkSliderRepresentation.h>
-#include <vtkSliderWidget.h>
 #include <vtkSmartPointer.h>
 
-/*****************************************************************************/
-class ModelBuilder;
-/*****************************************************************************/
-class vtkButtonCallback : public vtkCommand {
- public:
-  static vtkButtonCallback* New() { return new vtkButtonCallback; }
-  virtual void Execute(vtkObject* caller, unsigned long, void*);
-  vtkButtonCallback();
-  void setParent(ModelBuilder* parent);
+#include <memory>
+#include <vector>
 
- private:
-  ModelBuilder* parent = nullptr;
-};
-/*****************************************************************************/
-class vtkSliderCallback : public vtkCommand {
- public:
-  static vtkSliderCallback* New() { return new vtkSliderCallback; }
-  virtual void Execute(vtkObject* caller, unsigned long, void*);
-  vtkSliderCallback();
-  void setParent(ModelBuilder* parent);
+#include "buffer_pool.h"
+#include "build_options.h"
+#include "compressed_volume.h"
+#include "label_classifier.h"
+#include "model_cache.h"
 
- private:
-  ModelBuilder* parent = nullptr;
-};
 /*****************************************************************************/
 class ModelBuilder {
  public:
-  explicit ModelBuilder(vtkSmartPointer<vtkImageData> image_data_);
-  void buttonEvent(vtkSmartPointer<vtkButtonCallback> button);
-  void sliderEvent(vtkSmartPointer<vtkSliderCallback> slider, double value);
+  // Объём может быть общим для нескольких сборщиков в разных потоках:
+  // сборщик работает с собственной поверхностной копией и только читает его
+  ModelBuilder(vtkSmartPointer<vtkImageData> image_data_,
+               const std::string& volume_key_, const BuildOptions& options_);
 
  public:
-  vtkSmartPointer<vtkButtonCallback> getBuildButtonCallback() const;
-  vtkSmartPointer<vtkButtonCallback> getSaveButtonCallback() const;
-  vtkSmartPointer<vtkSliderCallback> getRadiusSliderCallback() const;
-  vtkSmartPointer<vtkSliderCallback> getDeviationSliderCallback() const;
-  vtkSmartPointer<vtkSliderCallback> getThresholdSliderCallback() const;
-  vtkSmartPointer<vtkSliderCallback> getMorphSliderCallback() const;
+  void buildModel();
+  void saveModel();
+  void setMorphRadius(double value);
+  void setGaussRadius(double value);
+  void setGaussDeviation(double value);
+  void setTreshold(double value);
 
  public:
   double getUpperScalarRange();
   double getLowerScalarRange();
   vtkSmartPointer<vtkPolyData> getModel();
+  vtkSmartPointer<vtkPolyData> getLabelModel(std::size_t index);
+  std::size_t getNumberOfLabelModels() const;
   vtkSmartPointer<vtkImageHistogram> getHistogram();
+  // nullptr, если пул отключён (buffer_pool_mb = 0)
+  const BufferPool* getBufferPool() const;
+
+ public:
+  // Превью порога и сглаживания на одном срезе: пересчитывается только слой
+  // толщиной в радиус ядра вокруг среза
+  void getVolumeExtent(int* extent) const;
+  vtkSmartPointer<vtkImageData> getSourceSlice(int axis, int index);
+  vtkSmartPointer<vtkImageData> getPreviewSlice(int axis, int index);
 
  private:
   void initHistogram();
-  void initCallbacks();
   void initParameters();
-  void saveModel();
-  void buildModel();
-  void setMorphRadius(double value);
-  void setGaussRadius(double value);
-  void setGaussDeviation(double value);
-  void setTreshold(double value);
+  void initCache();
+  void initCompression();
+  void initBufferPool();
+  void printBufferPoolStats() const;
+  void buildSurfaceModel();
+  vtkSmartPointer<vtkPolyData> extractSurface(vtkImageData* mask,
+                                              bool mesh_smoothing);
+  void benchmarkSmoothing(vtkImageData* mask, vtkPolyData* surface,
+                          bool mesh_smoothing);
+  vtkSmartPointer<vtkImageData> thresholdVolume();
+  vtkSmartPointer<vtkImageData> thresholdImage(vtkImageData* input);
+  vtkSmartPointer<vtkImageData> extractSourceVOI(const int* voi);
+  void getSlabExtent(int axis, int index, int half_width, int* extent) const;
+  vtkSmartPointer<vtkImageData> getSourceVolume();
+  void buildLabelModels();
+  void appendLabelModels();
+  std::string getCacheDescription() const;
+  bool loadCachedModel();
+  void storeCachedModel();
+  std::vector<double> getPreviewKernel() const;
+  void writeModel(vtkSmartPointer<vtkPolyData> polydata,
+                  const std::string& filepath);
 
  private:
   double morph_radius;
   double gauss_radius;
   double gauss_deviation;
   double threshold;
+  std::string smoothing_mode;
+  double scalar_range[2];
+  int volume_extent[6];
   vtkSmartPointer<vtkImageData> image_data;
+  std::unique_ptr<CompressedVolume> compressed_volume;
   vtkSmartPointer<vtkImageHistogram> histogram;
   vtkSmartPointer<vtkPolyData> model;
-
-  vtkSmartPointer<vtkButtonCallback> save_button_callback;
-  vtkSmartPointer<vtkButtonCallback> build_button_callback;
-  vtkSmartPointer<vtkSliderCallback> morph_slider_callback;
-  vtkSmartPointer<vtkSliderCallback> radius_slider_callback;
-  vtkSmartPointer<vtkSliderCallback> deviation_slider_callback;
-  vtkSmartPointer<vtkSliderCallback> threshold_slider_callback;
+  std::vector<LabelRange> labels;
+  std::vector<vtkSmartPointer<vtkPolyData>> label_models;
+  std::string volume_key;
+  std::unique_ptr<ModelCache> cache;
+  std::unique_ptr<BufferPool> buffer_pool;
+  BuildOptions options;
 };
 /*****************************************************************************/
 #endif  // MODEL_BULDER
\ No newline at end of file
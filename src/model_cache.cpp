@@ -0,0 +1,207 @@
+#include "model_cache.h"
+
+#include <vtkFieldData.h>
+#include <vtkStringArray.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+/*****************************************************************************/
+ModelCache::ModelCache(const std::string& directory_,
+                       std::uintmax_t max_bytes_)
+    : hits(0), misses(0) {
+  directory = directory_;
+  max_bytes = max_bytes_;
+  std::filesystem::create_directories(directory);
+}
+/*****************************************************************************/
+std::string ModelCache::makeKey(const std::string& description) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : description) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  std::ostringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return stream.str();
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> ModelCache::load(
+    const std::string& description) {
+  std::string path = getEntryPath(makeKey(description));
+  vtkNew<vtkXMLPolyDataReader> reader;
+  {
+    DirectoryLock lock(directory, LOCK_SH);
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+      ++misses;
+      return nullptr;
+    }
+    reader->SetFileName(path.c_str());
+    reader->Update();
+    // Время изменения служит меткой последнего использования при вытеснении
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), error);
+  }
+
+  if (reader->GetErrorCode() != 0) {
+    ++misses;
+    return nullptr;
+  }
+  vtkSmartPointer<vtkPolyData> polydata = reader->GetOutput();
+  vtkStringArray* stored = vtkStringArray::SafeDownCast(
+      polydata->GetFieldData()->GetAbstractArray(description_array.c_str()));
+  if (!stored || stored->GetNumberOfValues() != 1 ||
+      stored->GetValue(0) != description) {
+    std::cout << "Cache entry " << path << " belongs to other input"
+              << std::endl;
+    ++misses;
+    return nullptr;
+  }
+  polydata->GetFieldData()->RemoveArray(description_array.c_str());
+  ++hits;
+  return polydata;
+}
+/*****************************************************************************/
+void ModelCache::store(const std::string& description,
+                       vtkPolyData* polydata) {
+  std::string path = getEntryPath(makeKey(description));
+  // Имя уникально для каждого писателя: один ключ могут одновременно
+  // сохранять и разные процессы, и разные сборщики одного процесса
+  std::string tmp_template = path + tmp_marker + "XXXXXX";
+  std::vector<char> tmp_name(tmp_template.begin(), tmp_template.end());
+  tmp_name.push_back('\0');
+  int tmp_fd = mkstemp(tmp_name.data());
+  if (tmp_fd < 0) {
+    std::cout << "Can't create cache entry " << path << std::endl;
+    return;
+  }
+  close(tmp_fd);
+  std::string tmp_path = tmp_name.data();
+
+  // Описание кладётся в копию, модель сборщика не меняется
+  vtkNew<vtkStringArray> stored;
+  stored->SetName(description_array.c_str());
+  stored->InsertNextValue(description);
+  vtkNew<vtkPolyData> entry;
+  entry->ShallowCopy(polydata);
+  entry->GetFieldData()->AddArray(stored);
+
+  // Без сжатия и base64: данные пишутся сырым бинарным блоком
+  vtkNew<vtkXMLPolyDataWriter> writer;
+  writer->SetFileName(tmp_path.c_str());
+  writer->SetInputData(entry);
+  writer->SetDataModeToAppended();
+  writer->EncodeAppendedDataOff();
+  writer->SetCompressorTypeToNone();
+  if (writer->Write() == 0) {
+    std::error_code error;
+    std::filesystem::remove(tmp_path, error);
+    std::cout << "Can't write cache entry " << path << std::endl;
+    return;
+  }
+
+  DirectoryLock lock(directory, LOCK_EX);
+  std::error_code error;
+  std::filesystem::rename(tmp_path, path, error);
+  if (error) {
+    std::filesystem::remove(tmp_path, error);
+    std::cout << "Can't store cache entry " << path << std::endl;
+  }
+}
+/*****************************************************************************/
+std::size_t ModelCache::getHits() const { return hits; }
+/*****************************************************************************/
+std::size_t ModelCache::getMisses() const { return misses; }
+/*****************************************************************************/
+std::string ModelCache::getEntryPath(const std::string& key) const {
+  return directory + "/" + key + entry_extension;
+}
+/*****************************************************************************/
+ModelCache::DirectoryLock::DirectoryLock(const std::string& directory,
+                                         int operation) {
+  // Блокировка общая для всех процессов, работающих с этим каталогом
+  std::string lock_path = directory + "/.lock";
+  fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    throw std::runtime_error("Can't open cache lock " + lock_path);
+  }
+  if (flock(fd, operation) != 0) {
+    close(fd);
+    throw std::runtime_error("Can't lock cache " + directory);
+  }
+}
+/*****************************************************************************/
+ModelCache::DirectoryLock::~DirectoryLock() {
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+/*****************************************************************************/
+void ModelCache::evict() {
+  // Временный файл моложе этого срока может ещё писаться другим процессом
+  const auto stale_age = std::chrono::hours(1);
+  const auto now = std::filesystem::file_time_type::clock::now();
+
+  struct Entry {
+    std::filesystem::path path;
+    std::uintmax_t size;
+    std::filesystem::file_time_type time;
+  };
+  std::vector<Entry> entries;
+  std::uintmax_t total = 0;
+  DirectoryLock lock(directory, LOCK_EX);
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(directory, error), end;
+       !error && it != end; it.increment(error)) {
+    if (it->path().filename().string().find(tmp_marker) !=
+        std::string::npos) {
+      std::error_code tmp_error;
+      auto time = it->last_write_time(tmp_error);
+      if (!tmp_error && now - time > stale_age) {
+        std::filesystem::remove(it->path(), tmp_error);
+      }
+      continue;
+    }
+    if (it->path().extension() != entry_extension) {
+      continue;
+    }
+    // Запись могла исчезнуть после обхода - пропускаем её
+    std::error_code size_error;
+    std::error_code time_error;
+    Entry entry{it->path(), it->file_size(size_error),
+                it->last_write_time(time_error)};
+    if (size_error || time_error) {
+      continue;
+    }
+    total += entry.size;
+    entries.push_back(entry);
+  }
+  if (max_bytes == 0 || total <= max_bytes) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.time < b.time; });
+  for (const Entry& entry : entries) {
+    if (total <= max_bytes) {
+      break;
+    }
+    if (std::filesystem::remove(entry.path, error)) {
+      total -= entry.size;
+    }
+  }
+}
+/*****************************************************************************/
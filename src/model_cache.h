@@ -0,0 +1,59 @@
+#ifndef MODEL_CACHE
+#define MODEL_CACHE
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*****************************************************************************/
+class ModelCache {
+ public:
+  // max_bytes_ 0 - размер каталога не ограничен
+  ModelCache(const std::string& directory_, std::uintmax_t max_bytes_);
+
+ public:
+  // Ключ - 64-битный FNV-1a хеш полного описания входа и параметров.
+  // Само описание хранится в записи и сверяется при чтении, так что
+  // коллизия хеша даёт промах, а не чужую модель
+  static std::string makeKey(const std::string& description);
+  vtkSmartPointer<vtkPolyData> load(const std::string& description);
+  void store(const std::string& description, vtkPolyData* polydata);
+  // Вытесняет давно не использованные записи сверх max_bytes и удаляет
+  // временные файлы упавших писателей. Вызывается один раз после
+  // сохранения всего набора записей, а не после каждой
+  void evict();
+  std::size_t getHits() const;
+  std::size_t getMisses() const;
+
+ private:
+  // flock на файле блокировки каталога, снимается в деструкторе, в том
+  // числе при исключении
+  class DirectoryLock {
+   public:
+    DirectoryLock(const std::string& directory, int operation);
+    ~DirectoryLock();
+    DirectoryLock(DirectoryLock const&) = delete;
+    void operator=(DirectoryLock const&) = delete;
+
+   private:
+    int fd;
+  };
+
+  std::string getEntryPath(const std::string& key) const;
+
+ private:
+  std::string directory;
+  std::uintmax_t max_bytes;
+  std::atomic<std::size_t> hits;
+  std::atomic<std::size_t> misses;
+
+ public:
+  inline static const std::string entry_extension = ".vtp";
+  inline static const std::string tmp_marker = ".tmp.";
+  inline static const std::string description_array = "CacheDescription";
+};
+/*****************************************************************************/
+#endif  // MODEL_CACHE
@@ -0,0 +1,289 @@
+#include "recursive_gaussian.h"
+
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+/*****************************************************************************/
+namespace {
+template <typename T>
+void castToFloat(const T* in, float* out, vtkIdType slice_size, int slices) {
+  vtkSMPTools::For(0, slices, [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType idx = begin * slice_size; idx != end * slice_size; ++idx) {
+      out[idx] = static_cast<float>(in[idx]);
+    }
+  });
+}
+/*****************************************************************************/
+// Полосы подряд затронутых блоков вдоль axis, по списку на каждый столбец
+// блоков вдоль axis. Список лежит по индексу первого блока столбца, без
+// карты блоков - единственный столбец во всю длину. Считается один раз на
+// проход, а не для каждой строки
+std::vector<std::vector<std::pair<int, int>>> getRunTable(
+    const BrickMap* bricks, const std::vector<char>& affected, int axis,
+    int length) {
+  if (!bricks) {
+    return {{{0, length}}};
+  }
+  int counts[3];
+  bricks->getBrickCounts(counts);
+  int last[3] = {counts[0], counts[1], counts[2]};
+  last[axis] = 1;
+  std::vector<std::vector<std::pair<int, int>>> table(
+      bricks->getNumberOfBricks());
+  for (int k = 0; k != last[2]; ++k) {
+    for (int j = 0; j != last[1]; ++j) {
+      for (int i = 0; i != last[0]; ++i) {
+        std::vector<std::pair<int, int>>& runs =
+            table[bricks->getBrickIndex(i, j, k)];
+        int index[3] = {i, j, k};
+        bool open = false;
+        for (int n = 0; n != counts[axis]; ++n) {
+          index[axis] = n;
+          if (!affected[bricks->getBrickIndex(index[0], index[1],
+                                              index[2])]) {
+            open = false;
+            continue;
+          }
+          int range[2];
+          bricks->getOwnedRange(axis, n, range);
+          if (open) {
+            runs.back().second = range[1];
+          } else {
+            runs.emplace_back(range[0], range[1]);
+            open = true;
+          }
+        }
+      }
+    }
+  }
+  return table;
+}
+/*****************************************************************************/
+// Индекс в таблице полос для столбца блоков вдоль axis через position
+int getRunColumn(const BrickMap* bricks, int axis, const int* position) {
+  if (!bricks) {
+    return 0;
+  }
+  int index[3];
+  for (int a = 0; a != 3; ++a) {
+    index[a] = a == axis ? 0 : bricks->getOwnerBrick(a, position[a]);
+  }
+  return bricks->getBrickIndex(index[0], index[1], index[2]);
+}
+/*****************************************************************************/
+// Диапазоны x столбцов блоков
+std::vector<std::pair<int, int>> getColumns(const BrickMap* bricks, int nx) {
+  if (!bricks) {
+    return {{0, nx}};
+  }
+  int counts[3];
+  bricks->getBrickCounts(counts);
+  std::vector<std::pair<int, int>> columns;
+  for (int i = 0; i != counts[0]; ++i) {
+    int range[2];
+    bricks->getOwnedRange(0, i, range);
+    columns.emplace_back(range[0], range[1]);
+  }
+  return columns;
+}
+}  // namespace
+/*****************************************************************************/
+RecursiveGaussian::RecursiveGaussian(double sigma_) {
+  if (sigma_ < 0.0) {
+    throw std::runtime_error("Negative gaussian deviation");
+  }
+  sigma = sigma_;
+
+  // Young, van Vliet. Recursive implementation of the Gaussian filter, 1995
+  double q = 0.0;
+  if (sigma >= 2.5) {
+    q = 0.98711 * sigma - 0.96330;
+  } else if (sigma >= 0.5) {
+    q = 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+  }
+  double q2 = q * q;
+  double q3 = q2 * q;
+  double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+  double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+  double b2 = -(1.4281 * q2 + 1.26661 * q3);
+  double b3 = 0.422205 * q3;
+
+  a1 = static_cast<float>(b1 / b0);
+  a2 = static_cast<float>(b2 / b0);
+  a3 = static_cast<float>(b3 / b0);
+  b = static_cast<float>(1.0 - (b1 + b2 + b3) / b0);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> RecursiveGaussian::smooth(
+    vtkImageData* input, BufferPool* pool) const {
+  return filterVolume(input, nullptr, pool);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> RecursiveGaussian::smooth(
+    vtkImageData* input, const BrickMap& bricks, BufferPool* pool) const {
+  return filterVolume(input, &bricks, pool);
+}
+/*****************************************************************************/
+int RecursiveGaussian::getReach() const {
+  return static_cast<int>(std::ceil(4.0 * sigma));
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> RecursiveGaussian::filterVolume(
+    vtkImageData* input, const BrickMap* bricks, BufferPool* pool) const {
+  if (input->GetNumberOfScalarComponents() != 1) {
+    throw std::runtime_error("Recursive gaussian needs one component");
+  }
+  int dims[3];
+  input->GetDimensions(dims);
+
+  vtkSmartPointer<vtkImageData> output = BufferPool::allocateImage(
+      pool, input->GetExtent(), input->GetOrigin(), input->GetSpacing(),
+      VTK_FLOAT);
+
+  float* data = static_cast<float*>(output->GetScalarPointer());
+  vtkIdType slice_size = static_cast<vtkIdType>(dims[0]) * dims[1];
+  switch (input->GetScalarType()) {
+    vtkTemplateMacro(castToFloat(
+        static_cast<const VTK_TT*>(input->GetScalarPointer()), data,
+        slice_size, dims[2]));
+    default:
+      throw std::runtime_error("Unsupported scalar type for smoothing");
+  }
+
+  // При sigma < 0.5 фильтр вырождается в тождественный
+  if (sigma < 0.5) {
+    return output;
+  }
+  if (!bricks) {
+    std::vector<char> affected;
+    filterX(data, dims, nullptr, affected);
+    filterY(data, dims, nullptr, affected);
+    filterZ(data, dims, nullptr, affected);
+    return output;
+  }
+  // Вне полос данные постоянны и фильтр их не меняет
+  BrickActivity activity(*bricks);
+  std::vector<char> affected = activity.getAffected(0, getReach());
+  filterX(data, dims, bricks, affected);
+  activity.update(affected);
+  affected = activity.getAffected(1, getReach());
+  filterY(data, dims, bricks, affected);
+  activity.update(affected);
+  affected = activity.getAffected(2, getReach());
+  filterZ(data, dims, bricks, affected);
+  return output;
+}
+/*****************************************************************************/
+void RecursiveGaussian::filterX(float* data, const int* dims,
+                                const BrickMap* bricks,
+                                const std::vector<char>& affected) const {
+  // Строки независимы, параллелим по срезам. Граничные значения
+  // продолжаются константой, что соответствует установившемуся режиму.
+  // Рекурсия вдоль строки последовательна и, в отличие от проходов по y и
+  // z, не векторизуется: несколько строк за раз здесь не обрабатываются
+  int nx = dims[0];
+  vtkIdType rows_per_slice = dims[1];
+  std::vector<std::vector<Run>> table = getRunTable(bricks, affected, 0, nx);
+  vtkSMPTools::For(0, dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z != end; ++z) {
+      for (vtkIdType y = 0; y != rows_per_slice; ++y) {
+        float* row = data + (z * rows_per_slice + y) * nx;
+        int position[3] = {0, static_cast<int>(y), static_cast<int>(z)};
+        for (const Run& run : table[getRunColumn(bricks, 0, position)]) {
+          float w1 = row[run.first], w2 = w1, w3 = w1;
+          for (int x = run.first; x != run.second; ++x) {
+            float w = b * row[x] + a1 * w1 + a2 * w2 + a3 * w3;
+            row[x] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+          }
+          w1 = w2 = w3 = row[run.second - 1];
+          for (int x = run.second - 1; x >= run.first; --x) {
+            float w = b * row[x] + a1 * w1 + a2 * w2 + a3 * w3;
+            row[x] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+          }
+        }
+      }
+    }
+  });
+}
+/*****************************************************************************/
+void RecursiveGaussian::filterY(float* data, const int* dims,
+                                const BrickMap* bricks,
+                                const std::vector<char>& affected) const {
+  // Рекурсия идёт по y, внутренний цикл по x - непрерывный и векторизуется.
+  // Полосы вдоль y свои для каждого столбца блоков по x
+  int nx = dims[0];
+  int ny = dims[1];
+  vtkIdType slice_size = static_cast<vtkIdType>(nx) * ny;
+  std::vector<Run> columns = getColumns(bricks, nx);
+  std::vector<std::vector<Run>> table = getRunTable(bricks, affected, 1, ny);
+  vtkSMPTools::For(0, dims[2], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType z = begin; z != end; ++z) {
+      float* slice = data + z * slice_size;
+      for (const Run& column : columns) {
+        int position[3] = {column.first, 0, static_cast<int>(z)};
+        for (const Run& run : table[getRunColumn(bricks, 1, position)]) {
+          filterRows(slice, nx, column, run);
+        }
+      }
+    }
+  });
+}
+/*****************************************************************************/
+void RecursiveGaussian::filterZ(float* data, const int* dims,
+                                const BrickMap* bricks,
+                                const std::vector<char>& affected) const {
+  // Рекурсия идёт по z, параллелим по строкам y, внутренний цикл по x
+  int nx = dims[0];
+  vtkIdType slice_size = static_cast<vtkIdType>(nx) * dims[1];
+  std::vector<Run> columns = getColumns(bricks, nx);
+  std::vector<std::vector<Run>> table =
+      getRunTable(bricks, affected, 2, dims[2]);
+  vtkSMPTools::For(0, dims[1], [&](vtkIdType begin, vtkIdType end) {
+    for (vtkIdType y = begin; y != end; ++y) {
+      float* column_data = data + y * nx;
+      for (const Run& column : columns) {
+        int position[3] = {column.first, static_cast<int>(y), 0};
+        for (const Run& run : table[getRunColumn(bricks, 2, position)]) {
+          filterRows(column_data, slice_size, column, run);
+        }
+      }
+    }
+  });
+}
+/*****************************************************************************/
+void RecursiveGaussian::filterRows(float* data, vtkIdType stride,
+                                   const Run& columns, const Run& run) const {
+  // Строки run.first..run.second через stride, в каждой x из columns.
+  // За краем полосы значения продолжаются константой
+  int first = run.first;
+  int last = run.second - 1;
+  for (int i = first; i <= last; ++i) {
+    float* row = data + i * stride;
+    const float* r1 = data + std::max(i - 1, first) * stride;
+    const float* r2 = data + std::max(i - 2, first) * stride;
+    const float* r3 = data + std::max(i - 3, first) * stride;
+    for (int x = columns.first; x != columns.second; ++x) {
+      row[x] = b * row[x] + a1 * r1[x] + a2 * r2[x] + a3 * r3[x];
+    }
+  }
+  for (int i = last; i >= first; --i) {
+    float* row = data + i * stride;
+    const float* r1 = data + std::min(i + 1, last) * stride;
+    const float* r2 = data + std::min(i + 2, last) * stride;
+    const float* r3 = data + std::min(i + 3, last) * stride;
+    for (int x = columns.first; x != columns.second; ++x) {
+      row[x] = b * row[x] + a1 * r1[x] + a2 * r2[x] + a3 * r3[x];
+    }
+  }
+}
+/*****************************************************************************/
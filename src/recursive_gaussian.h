@@ -0,0 +1,54 @@
+#ifndef RECURSIVE_GAUSSIAN
+#define RECURSIVE_GAUSSIAN
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <utility>
+#include <vector>
+
+#include "brick_map.h"
+#include "buffer_pool.h"
+
+/*****************************************************************************/
+class RecursiveGaussian {
+ public:
+  explicit RecursiveGaussian(double sigma_);
+
+ public:
+  // Рекурсивный гаусс Янга - ван Флита: стоимость на воксель не зависит от
+  // sigma. Результат всегда float, буфер берётся из pool, если он задан
+  vtkSmartPointer<vtkImageData> smooth(vtkImageData* input,
+                                       BufferPool* pool = nullptr) const;
+  // Рекурсия идёт только по полосам блоков, до которых фильтр, обрезанный
+  // на getReach, достаёт от непостоянных блоков bricks
+  vtkSmartPointer<vtkImageData> smooth(vtkImageData* input,
+                                       const BrickMap& bricks,
+                                       BufferPool* pool = nullptr) const;
+  int getReach() const;
+
+ private:
+  // Полуинтервал индексов вдоль одной оси
+  using Run = std::pair<int, int>;
+
+  vtkSmartPointer<vtkImageData> filterVolume(vtkImageData* input,
+                                             const BrickMap* bricks,
+                                             BufferPool* pool) const;
+  void filterX(float* data, const int* dims, const BrickMap* bricks,
+               const std::vector<char>& affected) const;
+  void filterY(float* data, const int* dims, const BrickMap* bricks,
+               const std::vector<char>& affected) const;
+  void filterZ(float* data, const int* dims, const BrickMap* bricks,
+               const std::vector<char>& affected) const;
+  void filterRows(float* data, vtkIdType stride, const Run& columns,
+                  const Run& run) const;
+
+ private:
+  double sigma;
+  float b;
+  float a1;
+  float a2;
+  float a3;
+};
+/*****************************************************************************/
+#endif  // RECURSIVE_GAUSSIAN
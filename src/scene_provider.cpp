@@ -1,19 +1,51 @@
 #include "scene_provider.h"
 
+#include <vtkCamera.h>
 #include <vtkCoordinate.h>
+#include <vtkImageProperty.h>
 #include <vtkImageSlice.h>
 #include <vtkImageSliceMapper.h>
+#include <vtkImageStack.h>
 #include <vtkInteractorStyleTrackballCamera.h>
+#include <vtkLookupTable.h>
 #include <vtkPNGReader.h>
 #include <vtkProperty.h>
 #include <vtkSliderRepresentation2D.h>
+#include <vtkSliderWidget.h>
 #include <vtkTexturedButtonRepresentation2D.h>
 
-#include "config_reader.h"
 #include "model_builder.h"
 
 /*****************************************************************************/
-SceneProvider::SceneProvider(ModelBuilder* model_builder) {
+void vtkButtonCallback::Execute(vtkObject* caller, unsigned long, void*) {
+  parent->buttonEvent(this);
+}
+/*****************************************************************************/
+vtkButtonCallback::vtkButtonCallback() {}
+/*****************************************************************************/
+void vtkButtonCallback::setParent(SceneProvider* parent) {
+  this->parent = parent;
+}
+/*****************************************************************************/
+void vtkSliderCallback::Execute(vtkObject* caller, unsigned long, void*) {
+  vtkSliderWidget* sliderWidget = reinterpret_cast<vtkSliderWidget*>(caller);
+  double value =
+      static_cast<vtkSliderRepresentation*>(sliderWidget->GetRepresentation())
+          ->GetValue();
+  parent->sliderEvent(this, value);
+}
+/*****************************************************************************/
+vtkSliderCallback::vtkSliderCallback() {}
+/*****************************************************************************/
+void vtkSliderCallback::setParent(SceneProvider* parent) {
+  this->parent = parent;
+}
+/*****************************************************************************/
+SceneProvider::SceneProvider(ModelBuilder* model_builder_,
+                             const BuildOptions& options) {
+  model_builder = model_builder_;
+  initCallbacks();
+
   // Scene
   renderer = vtkSmartPointer<vtkRenderer>::New();
   renderer->SetBackground(0.2, 0.224, 0.278);
@@ -39,16 +71,17 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   renderer->AddActor(actor);
 
   // Histogram actor
-  if (ConfigReader::getInstance()->getVisualizateHistogram()) {
+  if (options.visualizate_histogram) {
     vtkNew<vtkImageSliceMapper> image_mapper;
-    image_mapper->SetInputConnection(
-        model_builder->getHistogram()->GetOutputPort());
+    image_mapper->SetInputData(model_builder->getHistogram()->GetOutput());
     image_mapper->BorderOff();
     vtkNew<vtkImageSlice> image_slice;
     image_slice->SetMapper(image_mapper);
     renderer->AddViewProp(image_slice);
   }
 
+  initSlicePreviews();
+
   // Build button
   vtkNew<vtkPNGReader> build_reader;
   build_reader->SetFileName("../import/build.png");
@@ -64,7 +97,7 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   build_widget->SetInteractor(interactor);
   build_widget->SetRepresentation(build_representation);
   build_widget->AddObserver(vtkCommand::StateChangedEvent,
-                            model_builder->getBuildButtonCallback());
+                            build_button_callback);
   build_widget->On();
 
   // Save button
@@ -82,14 +115,14 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   save_widget->SetInteractor(interactor);
   save_widget->SetRepresentation(save_representation);
   save_widget->AddObserver(vtkCommand::StateChangedEvent,
-                           model_builder->getSaveButtonCallback());
+                           save_button_callback);
   save_widget->On();
 
   // Morph slider
   vtkNew<vtkSliderRepresentation2D> morph_slider;
   morph_slider->SetMinimumValue(1.0);
   morph_slider->SetMaximumValue(13.0);
-  morph_slider->SetValue(ConfigReader::getInstance()->getMorphRadius());
+  morph_slider->SetValue(options.morph_radius);
   morph_slider->SetTitleText("MorphRadius");
   morph_slider->GetPoint1Coordinate()->SetCoordinateSystemToNormalizedDisplay();
   morph_slider->GetPoint2Coordinate()->SetCoordinateSystemToNormalizedDisplay();
@@ -103,13 +136,13 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   morph_widget->SetAnimationModeToAnimate();
   morph_widget->EnabledOn();
   morph_widget->AddObserver(vtkCommand::InteractionEvent,
-                            model_builder->getMorphSliderCallback());
+                            morph_slider_callback);
 
   // Threshold slider
   vtkNew<vtkSliderRepresentation2D> thresh_slider;
   thresh_slider->SetMinimumValue(model_builder->getLowerScalarRange());
   thresh_slider->SetMaximumValue(model_builder->getUpperScalarRange() / 5);
-  thresh_slider->SetValue(ConfigReader::getInstance()->getThreshold());
+  thresh_slider->SetValue(options.threshold);
   thresh_slider->SetTitleText("BinaryThreshold");
   thresh_slider->GetPoint1Coordinate()
       ->SetCoordinateSystemToNormalizedDisplay();
@@ -125,13 +158,13 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   threshold_widget->SetAnimationModeToAnimate();
   threshold_widget->EnabledOn();
   threshold_widget->AddObserver(vtkCommand::InteractionEvent,
-                                model_builder->getThresholdSliderCallback());
+                                threshold_slider_callback);
 
   // Radius slider
   vtkNew<vtkSliderRepresentation2D> radius_rep;
   radius_rep->SetMinimumValue(0.0);
   radius_rep->SetMaximumValue(9.0);
-  radius_rep->SetValue(ConfigReader::getInstance()->getGaussRadius());
+  radius_rep->SetValue(options.gauss_radius);
   radius_rep->SetTitleText("GaussRadius");
   radius_rep->GetPoint1Coordinate()->SetCoordinateSystemToNormalizedDisplay();
   radius_rep->GetPoint2Coordinate()->SetCoordinateSystemToNormalizedDisplay();
@@ -145,13 +178,13 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   radius_widget->SetAnimationModeToAnimate();
   radius_widget->EnabledOn();
   radius_widget->AddObserver(vtkCommand::InteractionEvent,
-                             model_builder->getRadiusSliderCallback());
+                             radius_slider_callback);
 
   // Deviation slider
   vtkNew<vtkSliderRepresentation2D> deviation_rep;
   deviation_rep->SetMinimumValue(0.0);
   deviation_rep->SetMaximumValue(9.0);
-  deviation_rep->SetValue(ConfigReader::getInstance()->getGaussDeviation());
+  deviation_rep->SetValue(options.gauss_deviation);
   deviation_rep->SetTitleText("GaussDeviation");
   deviation_rep->GetPoint1Coordinate()
       ->SetCoordinateSystemToNormalizedDisplay();
@@ -167,17 +200,33 @@ SceneProvider::SceneProvider(ModelBuilder* model_builder) {
   deviation_widget->SetAnimationModeToAnimate();
   deviation_widget->EnabledOn();
   deviation_widget->AddObserver(vtkCommand::InteractionEvent,
-                                model_builder->getDeviationSliderCallback());
+                                deviation_slider_callback);
 }
 /*****************************************************************************/
-SceneProvider* SceneProvider::getInstance(ModelBuilder* model_builder) {
-  if (!provider) {
-    provider = new SceneProvider(model_builder);
+void SceneProvider::buttonEvent(vtkSmartPointer<vtkButtonCallback> button) {
+  if (button == build_button_callback) {
+    model_builder->buildModel();
+    setPolyData(model_builder->getModel());
+  } else if (button == save_button_callback) {
+    model_builder->saveModel();
   }
-  return provider;
 }
 /*****************************************************************************/
-SceneProvider* SceneProvider::getInstance() { return provider; }
+void SceneProvider::sliderEvent(vtkSmartPointer<vtkSliderCallback> slider,
+                                double value) {
+  if (slider == radius_slider_callback) {
+    model_builder->setGaussRadius(value);
+  } else if (slider == morph_slider_callback) {
+    model_builder->setMorphRadius(value);
+  } else if (slider == deviation_slider_callback) {
+    model_builder->setGaussDeviation(value);
+  } else if (slider == threshold_slider_callback) {
+    model_builder->setTreshold(value);
+  }
+  if (slider != morph_slider_callback) {
+    updateSlicePreviews();
+  }
+}
 /*****************************************************************************/
 void SceneProvider::start() {
   interactor->Initialize();
@@ -195,6 +244,100 @@ void SceneProvider::setPolyData(vtkSmartPointer<vtkPolyData> polydata) {
   mapper->Update();
 }
 /*****************************************************************************/
+void SceneProvider::initCallbacks() {
+  save_button_callback = vtkSmartPointer<vtkButtonCallback>::New();
+  build_button_callback = vtkSmartPointer<vtkButtonCallback>::New();
+  morph_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
+  radius_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
+  deviation_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
+  threshold_slider_callback = vtkSmartPointer<vtkSliderCallback>::New();
+
+  save_button_callback->setParent(this);
+  build_button_callback->setParent(this);
+  morph_slider_callback->setParent(this);
+  radius_slider_callback->setParent(this);
+  deviation_slider_callback->setParent(this);
+  threshold_slider_callback->setParent(this);
+}
+/*****************************************************************************/
+void SceneProvider::initSlicePreviews() {
+  int extent[6];
+  model_builder->getVolumeExtent(extent);
+  double level = (model_builder->getUpperScalarRange() +
+                  model_builder->getLowerScalarRange()) / 2;
+  double window = model_builder->getUpperScalarRange() -
+                  model_builder->getLowerScalarRange();
+
+  // Сглаженная маска поверх среза: прозрачная вне модели, красная внутри
+  vtkNew<vtkLookupTable> mask_table;
+  mask_table->SetRange(0, 1024);
+  mask_table->SetHueRange(0.0, 0.0);
+  mask_table->SetSaturationRange(1.0, 1.0);
+  mask_table->SetValueRange(1.0, 1.0);
+  mask_table->SetAlphaRange(0.0, 0.6);
+  mask_table->Build();
+
+  for (int axis = 0; axis != 3; ++axis) {
+    slice_indices[axis] = (extent[2 * axis] + extent[2 * axis + 1]) / 2;
+
+    vtkNew<vtkImageSliceMapper> source_mapper;
+    source_mapper->SetInputData(
+        model_builder->getSourceSlice(axis, slice_indices[axis]));
+    source_mapper->SetOrientation(axis);
+    source_mapper->SetSliceNumber(slice_indices[axis]);
+    source_mapper->BorderOff();
+    vtkNew<vtkImageSlice> source_slice;
+    source_slice->SetMapper(source_mapper);
+    source_slice->GetProperty()->SetColorWindow(window);
+    source_slice->GetProperty()->SetColorLevel(level);
+
+    preview_mappers[axis] = vtkSmartPointer<vtkImageSliceMapper>::New();
+    preview_mappers[axis]->SetOrientation(axis);
+    preview_mappers[axis]->SetSliceNumber(slice_indices[axis]);
+    preview_mappers[axis]->BorderOff();
+    vtkNew<vtkImageSlice> preview_slice;
+    preview_slice->SetMapper(preview_mappers[axis]);
+    preview_slice->GetProperty()->SetLookupTable(mask_table);
+    preview_slice->GetProperty()->UseLookupTableScalarRangeOn();
+    preview_slice->GetProperty()->SetLayerNumber(1);
+
+    vtkNew<vtkImageStack> stack;
+    stack->AddImage(source_slice);
+    stack->AddImage(preview_slice);
+
+    slice_renderers[axis] = vtkSmartPointer<vtkRenderer>::New();
+    slice_renderers[axis]->SetViewport(0.0, 0.25 + axis * 0.22, 0.22,
+                                       0.46 + axis * 0.22);
+    slice_renderers[axis]->SetBackground(0.0, 0.0, 0.0);
+    slice_renderers[axis]->InteractiveOff();
+    slice_renderers[axis]->AddViewProp(stack);
+    render_window->AddRenderer(slice_renderers[axis]);
+
+    vtkCamera* camera = slice_renderers[axis]->GetActiveCamera();
+    camera->ParallelProjectionOn();
+    camera->SetFocalPoint(0.0, 0.0, 0.0);
+    camera->SetPosition(axis == 0 ? 1.0 : 0.0, axis == 1 ? -1.0 : 0.0,
+                        axis == 2 ? 1.0 : 0.0);
+    if (axis == 2) {
+      camera->SetViewUp(0.0, 1.0, 0.0);
+    } else {
+      camera->SetViewUp(0.0, 0.0, 1.0);
+    }
+  }
+  updateSlicePreviews();
+  for (int axis = 0; axis != 3; ++axis) {
+    slice_renderers[axis]->ResetCamera();
+  }
+}
+/*****************************************************************************/
+void SceneProvider::updateSlicePreviews() {
+  // Пересчитываются только три среза с окрестностью ядра, не весь объём
+  for (int axis = 0; axis != 3; ++axis) {
+    preview_mappers[axis]->SetInputData(
+        model_builder->getPreviewSlice(axis, slice_indices[axis]));
+  }
+}
+/*****************************************************************************/
 void SceneProvider::calculateButtonBounds(double x_pos, double y_pos,
                                           double size, double* bounds) {
   vtkNew<vtkCoordinate> coordinate;
@@ -3,6 +3,8 @@
 
 #include <vtkActor.h>
 #include <vtkButtonWidget.h>
+#include <vtkCommand.h>
+#include <vtkImageSliceMapper.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
@@ -10,27 +12,55 @@
 #include <vtkSliderWidget.h>
 #include <vtkSmartPointer.h>
 
+#include "build_options.h"
+
 /*****************************************************************************/
 class ModelBuilder;
+class SceneProvider;
 /*****************************************************************************/
-class SceneProvider {
+class vtkButtonCallback : public vtkCommand {
+ public:
+  static vtkButtonCallback* New() { return new vtkButtonCallback; }
+  virtual void Execute(vtkObject* caller, unsigned long, void*);
+  vtkButtonCallback();
+  void setParent(SceneProvider* parent);
+
  private:
-  explicit SceneProvider(ModelBuilder* model_builder);
+  SceneProvider* parent = nullptr;
+};
+/*****************************************************************************/
+class vtkSliderCallback : public vtkCommand {
+ public:
+  static vtkSliderCallback* New() { return new vtkSliderCallback; }
+  virtual void Execute(vtkObject* caller, unsigned long, void*);
+  vtkSliderCallback();
+  void setParent(SceneProvider* parent);
 
+ private:
+  SceneProvider* parent = nullptr;
+};
+/*****************************************************************************/
+class SceneProvider {
  public:
-  static SceneProvider* getInstance(ModelBuilder* model_builder);
-  static SceneProvider* getInstance();
+  SceneProvider(ModelBuilder* model_builder_, const BuildOptions& options);
   SceneProvider(SceneProvider const&) = delete;
   void operator=(SceneProvider const&) = delete;
 
  public:
+  void buttonEvent(vtkSmartPointer<vtkButtonCallback> button);
+  void sliderEvent(vtkSmartPointer<vtkSliderCallback> slider, double value);
   void start();
   void setPolyData(vtkSmartPointer<vtkPolyData> polydata);
   void calculateButtonBounds(double x_pos, double y_pos, double size,
                              double* bounds);
 
  private:
-  inline static SceneProvider* provider = nullptr;
+  void initCallbacks();
+  void initSlicePreviews();
+  void updateSlicePreviews();
+
+ private:
+  ModelBuilder* model_builder;
 
   vtkSmartPointer<vtkRenderer> renderer;
   vtkSmartPointer<vtkRenderWindow> render_window;
@@ -39,12 +69,24 @@ class SceneProvider {
   vtkSmartPointer<vtkPolyDataMapper> mapper;
   vtkSmartPointer<vtkActor> actor;
 
+  // Три ортогональных среза исходного объёма с наложенной маской
+  int slice_indices[3];
+  vtkSmartPointer<vtkRenderer> slice_renderers[3];
+  vtkSmartPointer<vtkImageSliceMapper> preview_mappers[3];
+
   vtkSmartPointer<vtkSliderWidget> morph_widget;
   vtkSmartPointer<vtkSliderWidget> radius_widget;
   vtkSmartPointer<vtkSliderWidget> deviation_widget;
   vtkSmartPointer<vtkSliderWidget> threshold_widget;
   vtkSmartPointer<vtkButtonWidget> build_widget;
   vtkSmartPointer<vtkButtonWidget> save_widget;
+
+  vtkSmartPointer<vtkButtonCallback> save_button_callback;
+  vtkSmartPointer<vtkButtonCallback> build_button_callback;
+  vtkSmartPointer<vtkSliderCallback> morph_slider_callback;
+  vtkSmartPointer<vtkSliderCallback> radius_slider_callback;
+  vtkSmartPointer<vtkSliderCallback> deviation_slider_callback;
+  vtkSmartPointer<vtkSliderCallback> threshold_slider_callback;
 };
 /*****************************************************************************/
 #endif  // SCENE_PROVIDER
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "separable_gaussian.h"
+
+#include <vtkSMPTools.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/*****************************************************************************/
+namespace {
+// Свёртка вдоль axis вокселей затронутых блоков, остальные блоки
+// заполняются значением. Каждый блок пишет только свои воксели
+template <typename T>
+void convolveBricks(const T* in, float* out, const int* dims, int axis,
+                    const std::vector<double>& kernel, const BrickMap& bricks,
+                    const BrickActivity& activity,
+                    const std::vector<char>& affected) {
+  vtkIdType strides[3] = {1, dims[0],
+                          static_cast<vtkIdType>(dims[0]) * dims[1]};
+  int half_width = static_cast<int>(kernel.size() / 2);
+  // Сумма весов ядра, обрезанного границей объёма, для каждой позиции
+  std::vector<double> weights(dims[axis]);
+  for (int p = 0; p != dims[axis]; ++p) {
+    int first = std::max(p - half_width, 0);
+    int last = std::min(p + half_width, dims[axis] - 1);
+    for (int q = first; q <= last; ++q) {
+      weights[p] += kernel[q - p + half_width];
+    }
+  }
+
+  int counts[3];
+  bricks.getBrickCounts(counts);
+  vtkSMPTools::For(0, bricks.getNumberOfBricks(), [&](vtkIdType begin,
+                                                      vtkIdType end) {
+    for (vtkIdType brick = begin; brick != end; ++brick) {
+      int index[3] = {static_cast<int>(brick % counts[0]),
+                      static_cast<int>(brick / counts[0] % counts[1]),
+                      static_cast<int>(brick / (counts[0] * counts[1]))};
+      int range[3][2];
+      for (int a = 0; a != 3; ++a) {
+        bricks.getOwnedRange(a, index[a], range[a]);
+      }
+      float value = activity.getValue(static_cast<int>(brick));
+      for (int z = range[2][0]; z != range[2][1]; ++z) {
+        for (int y = range[1][0]; y != range[1][1]; ++y) {
+          vtkIdType row = y * strides[1] + z * strides[2];
+          if (!affected[brick]) {
+            std::fill(out + row + range[0][0], out + row + range[0][1],
+                      value);
+            continue;
+          }
+          int position[3] = {0, y, z};
+          for (int x = range[0][0]; x != range[0][1]; ++x) {
+            position[0] = x;
+            int p = position[axis];
+            int first = std::max(p - half_width, 0);
+            int last = std::min(p + half_width, dims[axis] - 1);
+            const T* line = in + row + x - p * strides[axis];
+            double sum = 0;
+            for (int q = first; q <= last; ++q) {
+              sum += kernel[q - p + half_width] *
+                     static_cast<double>(line[q * strides[axis]]);
+            }
+            out[row + x] = static_cast<float>(sum / weights[p]);
+          }
+        }
+      }
+    }
+  });
+}
+}  // namespace
+/*****************************************************************************/
+SeparableGaussian::SeparableGaussian(double sigma_, double radius_factor_) {
+  if (sigma_ < 0.0 || radius_factor_ < 0.0) {
+    throw std::runtime_error("Negative gaussian parameters");
+  }
+  int half_width = static_cast<int>(sigma_ * radius_factor_);
+  kernel.assign(2 * half_width + 1, 1.0);
+  for (int i = -half_width; i <= half_width && half_width > 0; ++i) {
+    kernel[i + half_width] = std::exp(-i * i / (2.0 * sigma_ * sigma_));
+  }
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> SeparableGaussian::smooth(
+    vtkImageData* input, const BrickMap& bricks, BufferPool* pool) const {
+  if (input->GetNumberOfScalarComponents() != 1) {
+    throw std::runtime_error("Gaussian smoothing needs one component");
+  }
+  int dims[3];
+  input->GetDimensions(dims);
+
+  vtkSmartPointer<vtkImageData> output = BufferPool::allocateImage(
+      pool, input->GetExtent(), input->GetOrigin(), input->GetSpacing(),
+      VTK_FLOAT);
+  PooledImage buffer(pool, BufferPool::allocateImage(
+                               pool, input->GetExtent(), input->GetOrigin(),
+                               input->GetSpacing(), VTK_FLOAT));
+  float* data = static_cast<float*>(output->GetScalarPointer());
+  float* temp = static_cast<float*>(buffer.get()->GetScalarPointer());
+
+  // x: вход -> output, y: output -> buffer, z: buffer -> output
+  BrickActivity activity(bricks);
+  std::vector<char> affected = activity.getAffected(0, getReach());
+  switch (input->GetScalarType()) {
+    vtkTemplateMacro(convolveBricks(
+        static_cast<const VTK_TT*>(input->GetScalarPointer()), data, dims, 0,
+        kernel, bricks, activity, affected));
+    default:
+      throw std::runtime_error("Unsupported scalar type for smoothing");
+  }
+  activity.update(affected);
+  affected = activity.getAffected(1, getReach());
+  convolveBricks<float>(data, temp, dims, 1, kernel, bricks, activity,
+                        affected);
+  activity.update(affected);
+  affected = activity.getAffected(2, getReach());
+  convolveBricks<float>(temp, data, dims, 2, kernel, bricks, activity,
+                        affected);
+  return output;
+}
+/*****************************************************************************/
+int SeparableGaussian::getReach() const {
+  return static_cast<int>(kernel.size() / 2);
+}
+/*****************************************************************************/
+const std::vector<double>& SeparableGaussian::getKernel() const {
+  return kernel;
+}
+/*****************************************************************************/
@@ -0,0 +1,33 @@
+#ifndef SEPARABLE_GAUSSIAN
+#define SEPARABLE_GAUSSIAN
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+#include "brick_map.h"
+#include "buffer_pool.h"
+
+/*****************************************************************************/
+class SeparableGaussian {
+ public:
+  // Ядро как у vtkImageGaussianSmooth: радиус sigma * radius_factor, у
+  // границы объёма обрезается и перенормируется
+  SeparableGaussian(double sigma_, double radius_factor_);
+
+ public:
+  // Три прохода по осям, каждый только по блокам, до которых ядро достаёт
+  // от непостоянных блоков bricks. Остальные блоки заполняются своим
+  // значением без свёртки. Результат float, буферы берутся из pool
+  vtkSmartPointer<vtkImageData> smooth(vtkImageData* input,
+                                       const BrickMap& bricks,
+                                       BufferPool* pool = nullptr) const;
+  int getReach() const;
+  const std::vector<double>& getKernel() const;
+
+ private:
+  std::vector<double> kernel;
+};
+/*****************************************************************************/
+#endif  // SEPARABLE_GAUSSIAN
@@ -0,0 +1,120 @@
+#include "series_selector.h"
+
+#include <vtkCamera.h>
+#include <vtkImageProperty.h>
+#include <vtkImageSlice.h>
+#include <vtkImageSliceMapper.h>
+#include <vtkInteractorStyleUser.h>
+#include <vtkTextActor.h>
+#include <vtkTextProperty.h>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+/*****************************************************************************/
+void vtkSeriesPickCallback::Execute(vtkObject* caller, unsigned long, void*) {
+  parent->pickEvent();
+}
+/*****************************************************************************/
+vtkSeriesPickCallback::vtkSeriesPickCallback() {}
+/*****************************************************************************/
+void vtkSeriesPickCallback::setParent(SeriesSelector* parent) {
+  this->parent = parent;
+}
+/*****************************************************************************/
+SeriesSelector::SeriesSelector(const std::vector<SeriesPreview>& previews_) {
+  if (previews_.empty()) {
+    throw std::runtime_error("No series to choose from");
+  }
+  previews = previews_;
+
+  render_window = vtkSmartPointer<vtkRenderWindow>::New();
+  render_window->SetWindowName("Выберите серию");
+
+  interactor = vtkSmartPointer<vtkRenderWindowInteractor>::New();
+  interactor->SetRenderWindow(render_window);
+  // Поворот и масштаб здесь не нужны, только щелчок по срезу
+  vtkNew<vtkInteractorStyleUser> style;
+  interactor->SetInteractorStyle(style);
+
+  pick_callback = vtkSmartPointer<vtkSeriesPickCallback>::New();
+  pick_callback->setParent(this);
+  interactor->AddObserver(vtkCommand::LeftButtonPressEvent, pick_callback);
+
+  initPreviews();
+}
+/*****************************************************************************/
+int SeriesSelector::select() {
+  interactor->Initialize();
+  interactor->Start();
+  if (selected_series < 0) {
+    throw std::runtime_error("Серия не выбрана");
+  }
+  return selected_series;
+}
+/*****************************************************************************/
+void SeriesSelector::pickEvent() {
+  int* position = interactor->GetEventPosition();
+  vtkRenderer* poked = interactor->FindPokedRenderer(position[0], position[1]);
+  for (std::size_t i = 0; i != renderers.size(); ++i) {
+    if (renderers[i] == poked) {
+      selected_series = previews[i].series;
+      render_window->Finalize();
+      interactor->TerminateApp();
+      return;
+    }
+  }
+}
+/*****************************************************************************/
+void SeriesSelector::initPreviews() {
+  int count = static_cast<int>(previews.size());
+  int columns = static_cast<int>(std::ceil(std::sqrt(count)));
+  int rows = (count + columns - 1) / columns;
+  render_window->SetSize(300 * columns, 300 * rows);
+
+  for (int i = 0; i != count; ++i) {
+    const SeriesPreview& preview = previews[i];
+
+    std::ostringstream caption;
+    caption << "№" << preview.series << " " << preview.description << "\n"
+            << preview.modality << " " << preview.rows << "x" << preview.cols
+            << ", " << preview.slices << " slices";
+    if (!preview.slice) {
+      caption << "\npreview unavailable";
+    }
+    vtkNew<vtkTextActor> text;
+    text->SetInput(caption.str().c_str());
+    text->SetPosition(5, 5);
+    text->GetTextProperty()->SetFontSize(14);
+
+    // Строки сетки сверху вниз
+    int column = i % columns;
+    int row = rows - 1 - i / columns;
+    vtkSmartPointer<vtkRenderer> renderer = vtkSmartPointer<vtkRenderer>::New();
+    renderer->SetViewport(static_cast<double>(column) / columns,
+                          static_cast<double>(row) / rows,
+                          static_cast<double>(column + 1) / columns,
+                          static_cast<double>(row + 1) / rows);
+    renderer->SetBackground(0.0, 0.0, 0.0);
+    if (preview.slice) {
+      vtkNew<vtkImageSliceMapper> mapper;
+      mapper->SetInputData(preview.slice);
+      mapper->SetSliceNumber(preview.slice->GetExtent()[4]);
+      mapper->BorderOff();
+      vtkNew<vtkImageSlice> slice;
+      slice->SetMapper(mapper);
+      slice->GetProperty()->SetColorWindow(preview.scalar_range[1] -
+                                           preview.scalar_range[0]);
+      slice->GetProperty()->SetColorLevel(
+          (preview.scalar_range[0] + preview.scalar_range[1]) / 2);
+      renderer->AddViewProp(slice);
+    }
+    renderer->AddActor2D(text);
+    renderer->GetActiveCamera()->ParallelProjectionOn();
+    renderer->ResetCamera();
+    render_window->AddRenderer(renderer);
+    renderers.push_back(renderer);
+  }
+}
+/*****************************************************************************/
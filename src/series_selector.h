@@ -0,0 +1,53 @@
+#ifndef SERIES_SELECTOR
+#define SERIES_SELECTOR
+
+#include <vtkCommand.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+#include <vector>
+
+#include "series_triage.h"
+
+/*****************************************************************************/
+class SeriesSelector;
+/*****************************************************************************/
+class vtkSeriesPickCallback : public vtkCommand {
+ public:
+  static vtkSeriesPickCallback* New() { return new vtkSeriesPickCallback; }
+  virtual void Execute(vtkObject* caller, unsigned long, void*);
+  vtkSeriesPickCallback();
+  void setParent(SeriesSelector* parent);
+
+ private:
+  SeriesSelector* parent = nullptr;
+};
+/*****************************************************************************/
+class SeriesSelector {
+ public:
+  // Средние срезы всех серий сеткой в одном окне, серия выбирается щелчком
+  explicit SeriesSelector(const std::vector<SeriesPreview>& previews_);
+  SeriesSelector(SeriesSelector const&) = delete;
+  void operator=(SeriesSelector const&) = delete;
+
+ public:
+  // Блокируется до выбора, закрытие окна без выбора - исключение
+  int select();
+  void pickEvent();
+
+ private:
+  void initPreviews();
+
+ private:
+  std::vector<SeriesPreview> previews;
+  int selected_series = -1;
+
+  vtkSmartPointer<vtkRenderWindow> render_window;
+  vtkSmartPointer<vtkRenderWindowInteractor> interactor;
+  std::vector<vtkSmartPointer<vtkRenderer>> renderers;
+  vtkSmartPointer<vtkSeriesPickCallback> pick_callback;
+};
+/*****************************************************************************/
+#endif  // SERIES_SELECTOR
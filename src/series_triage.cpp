@@ -0,0 +1,157 @@
+#include "series_triage.h"
+
+#include <vtkDICOMMetaData.h>
+#include <vtkDICOMReader.h>
+#include <vtkExtractVOI.h>
+#include <vtkImageResize.h>
+#include <vtkImageShiftScale.h>
+#include <vtkPNGWriter.h>
+#include <vtkSMPTools.h>
+#include <vtkStringArray.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "dicom_tags.h"
+
+/*****************************************************************************/
+SeriesTriage::SeriesTriage(vtkDICOMDirectory* dcm_dir_, int study_number_,
+                           int thumbnail_size_) {
+  dcm_dir = dcm_dir_;
+  study_number = study_number_;
+  thumbnail_size = thumbnail_size_;
+}
+/*****************************************************************************/
+void SeriesTriage::run() {
+  auto start = std::chrono::steady_clock::now();
+  int first_series = dcm_dir->GetFirstSeriesForStudy(study_number);
+  int last_series = dcm_dir->GetLastSeriesForStudy(study_number);
+
+  // Метаданные и имена файлов уже прочитаны сканированием каталога
+  previews.clear();
+  std::vector<std::string> filenames;
+  for (int i = first_series; i <= last_series; ++i) {
+    vtkDICOMMetaData* meta = dcm_dir->GetMetaDataForSeries(i);
+    vtkStringArray* files = dcm_dir->GetFileNamesForSeries(i);
+    SeriesPreview preview;
+    preview.series = i;
+    preview.description = meta->Get(DicomTags::description_tag).AsString();
+    preview.modality = meta->Get(DicomTags::modality_tag).AsString();
+    preview.rows = meta->Get(DicomTags::rows_tag).AsString();
+    preview.cols = meta->Get(DicomTags::cols_tag).AsString();
+    preview.slices = static_cast<int>(files->GetNumberOfValues());
+    previews.push_back(preview);
+    filenames.push_back(files->GetValue(files->GetNumberOfValues() / 2));
+  }
+
+  vtkSMPTools::For(0, static_cast<vtkIdType>(previews.size()), 1,
+                   [&](vtkIdType begin, vtkIdType end) {
+                     for (vtkIdType i = begin; i != end; ++i) {
+                       decodePreview(filenames[i], previews[i]);
+                     }
+                   });
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "series triage: " << previews.size() << " series, "
+            << elapsed.count() << " ms" << std::endl;
+}
+/*****************************************************************************/
+const std::vector<SeriesPreview>& SeriesTriage::getPreviews() const {
+  return previews;
+}
+/*****************************************************************************/
+void SeriesTriage::writeListing(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("Can't open file to write " + path);
+  }
+  std::filesystem::path stem = std::filesystem::path(path).replace_extension();
+  file << "№ |" << " description |" << " modality |" << " rows x cols |"
+       << " slices |" << " preview" << std::endl;
+  for (const SeriesPreview& preview : previews) {
+    std::string thumbnail = "unavailable";
+    if (preview.slice) {
+      thumbnail = stem.string() + "_" + std::to_string(preview.series) + ".png";
+      writeThumbnail(preview, thumbnail);
+    }
+    file << preview.series << " | " << preview.description << " | "
+         << preview.modality << " | " << preview.rows << "x" << preview.cols
+         << " | " << preview.slices << " | " << thumbnail << std::endl;
+  }
+  std::cout << "Series listing written to " << path << std::endl;
+}
+/*****************************************************************************/
+void SeriesTriage::decodePreview(const std::string& filename,
+                                 SeriesPreview& preview) const {
+  vtkNew<vtkDICOMReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->Update();
+
+  // Битый или неподдерживаемый файл не должен ронять отбор остальных
+  // серий: превью помечается недоступным
+  int extent[6];
+  reader->GetOutput()->GetExtent(extent);
+  if (reader->GetErrorCode() != 0 || extent[0] > extent[1] ||
+      extent[2] > extent[3] || extent[4] > extent[5]) {
+    std::cout << "Preview of series " << preview.series
+              << " is unavailable: can't decode " << filename << std::endl;
+    preview.slice = nullptr;
+    return;
+  }
+
+  // Многокадровый файл даёт несколько срезов - берём средний
+  int middle = (extent[4] + extent[5]) / 2;
+  vtkNew<vtkExtractVOI> extract;
+  extract->SetInputData(reader->GetOutput());
+  extract->SetVOI(extent[0], extent[1], extent[2], extent[3], middle, middle);
+  extract->Update();
+
+  preview.slice = makeThumbnail(extract->GetOutput());
+  preview.slice->GetScalarRange(preview.scalar_range);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> SeriesTriage::makeThumbnail(
+    vtkImageData* slice) const {
+  int dims[3];
+  slice->GetDimensions(dims);
+  if (dims[0] <= 0 || dims[1] <= 0) {
+    return slice;
+  }
+  double scale =
+      static_cast<double>(thumbnail_size) / std::max(dims[0], dims[1]);
+  if (thumbnail_size <= 0 || scale >= 1) {
+    return slice;
+  }
+
+  vtkNew<vtkImageResize> resize;
+  resize->SetInputData(slice);
+  resize->SetResizeMethodToOutputDimensions();
+  resize->SetOutputDimensions(
+      std::max(1, static_cast<int>(std::lround(dims[0] * scale))),
+      std::max(1, static_cast<int>(std::lround(dims[1] * scale))), 1);
+  resize->Update();
+  vtkSmartPointer<vtkImageData> thumbnail = resize->GetOutput();
+  return thumbnail;
+}
+/*****************************************************************************/
+void SeriesTriage::writeThumbnail(const SeriesPreview& preview,
+                                  const std::string& path) const {
+  double window = preview.scalar_range[1] - preview.scalar_range[0];
+  vtkNew<vtkImageShiftScale> shift_scale;
+  shift_scale->SetInputData(preview.slice);
+  shift_scale->SetShift(-preview.scalar_range[0]);
+  shift_scale->SetScale(window > 0 ? 255.0 / window : 1.0);
+  shift_scale->SetOutputScalarTypeToUnsignedChar();
+  shift_scale->ClampOverflowOn();
+
+  vtkNew<vtkPNGWriter> writer;
+  writer->SetFileName(path.c_str());
+  writer->SetInputConnection(shift_scale->GetOutputPort());
+  writer->Write();
+}
+/*****************************************************************************/
@@ -0,0 +1,53 @@
+#ifndef SERIES_TRIAGE
+#define SERIES_TRIAGE
+
+#include <vtkDICOMDirectory.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+#include <vector>
+
+/*****************************************************************************/
+struct SeriesPreview {
+  int series;
+  std::string description;
+  std::string modality;
+  std::string rows;
+  std::string cols;
+  int slices;
+  // Средний срез серии, уменьшенный до миниатюры. nullptr - файл не
+  // декодировался, превью серии недоступно
+  vtkSmartPointer<vtkImageData> slice;
+  double scalar_range[2] = {0, 0};
+};
+/*****************************************************************************/
+class SeriesTriage {
+ public:
+  // thumbnail_size_ - наибольшая сторона миниатюры в пикселях,
+  // 0 - срез остаётся в исходном разрешении
+  SeriesTriage(vtkDICOMDirectory* dcm_dir_, int study_number_,
+               int thumbnail_size_);
+
+ public:
+  // Из каждой серии декодируется только один файл, серии - параллельно
+  void run();
+  const std::vector<SeriesPreview>& getPreviews() const;
+  // Таблица серий и миниатюры <listing>_<series>.png рядом с ней
+  void writeListing(const std::string& path) const;
+
+ private:
+  void decodePreview(const std::string& filename,
+                     SeriesPreview& preview) const;
+  vtkSmartPointer<vtkImageData> makeThumbnail(vtkImageData* slice) const;
+  void writeThumbnail(const SeriesPreview& preview,
+                      const std::string& path) const;
+
+ private:
+  vtkSmartPointer<vtkDICOMDirectory> dcm_dir;
+  int study_number;
+  int thumbnail_size;
+  std::vector<SeriesPreview> previews;
+};
+/*****************************************************************************/
+#endif  // SERIES_TRIAGE
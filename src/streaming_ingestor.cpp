@@ -0,0 +1,229 @@
+#include "streaming_ingestor.h"
+
+#include <vtkDICOMMetaData.h>
+#include <vtkDICOMReader.h>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "dicom_tags.h"
+
+/*****************************************************************************/
+StreamingIngestor::StreamingIngestor(const std::string& directory_,
+                                     int expected_slices_,
+                                     double settle_seconds_) {
+  directory = directory_;
+  expected_slices = expected_slices_;
+  settle_seconds = settle_seconds_;
+  inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    throw std::runtime_error("Can't init inotify");
+  }
+  // Файл считается готовым только после закрытия на запись или переноса
+  if (inotify_add_watch(inotify_fd, directory.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    close(inotify_fd);
+    throw std::runtime_error("Can't watch directory " + directory);
+  }
+}
+/*****************************************************************************/
+StreamingIngestor::~StreamingIngestor() { close(inotify_fd); }
+/*****************************************************************************/
+void StreamingIngestor::run() {
+  // Наблюдение уже включено, поэтому файлы, появившиеся во время обхода,
+  // не потеряются, а повторы отсекаются по имени
+  scanDirectory();
+  auto last_slice_time = std::chrono::steady_clock::now();
+  while (!isComplete()) {
+    pollfd descriptor = {inotify_fd, POLLIN, 0};
+    int ready = poll(&descriptor, 1, 200);
+    if (ready < 0) {
+      throw std::runtime_error("Error while watching " + directory);
+    }
+    std::size_t before = slices.size();
+    if (ready > 0) {
+      readEvents();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (slices.size() != before) {
+      last_slice_time = now;
+      std::cout << "slices received: " << slices.size() << std::endl;
+    }
+    // Ожидаемое число срезов может быть неверным (ImagesInAcquisition
+    // считает и другие серии и эхо, часть срезов может быть отброшена),
+    // поэтому тишина дольше settle_seconds завершает приём всегда
+    double idle = std::chrono::duration<double>(now - last_slice_time).count();
+    if (!slices.empty() && idle >= settle_seconds) {
+      break;
+    }
+  }
+  if (expected_slices > 0 &&
+      static_cast<int>(slices.size()) < expected_slices) {
+    std::cout << "Warning: received " << slices.size() << " of "
+              << expected_slices << " expected slices" << std::endl;
+  }
+  assembleVolume();
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> StreamingIngestor::getImageData() {
+  return image_data;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkMatrix4x4> StreamingIngestor::getPatientMatrix() {
+  return patient_matrix;
+}
+/*****************************************************************************/
+std::string StreamingIngestor::getSeriesUid() { return series_uid; }
+/*****************************************************************************/
+void StreamingIngestor::scanDirectory() {
+  for (const auto& item : std::filesystem::directory_iterator(directory)) {
+    if (item.is_regular_file()) {
+      addFile(item.path().string());
+    }
+  }
+}
+/*****************************************************************************/
+void StreamingIngestor::readEvents() {
+  alignas(inotify_event) char buffer[4096];
+  ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+  for (ssize_t offset = 0; offset < length;) {
+    const inotify_event* event =
+        reinterpret_cast<const inotify_event*>(buffer + offset);
+    if (event->len > 0) {
+      addFile(directory + "/" + event->name);
+    }
+    offset += sizeof(inotify_event) + event->len;
+  }
+}
+/*****************************************************************************/
+void StreamingIngestor::addFile(const std::string& path) {
+  // Файл, который ещё дописывается, не читается. Он помечается увиденным
+  // только после удачного чтения, чтобы его IN_CLOSE_WRITE не пропал
+  if (seen_files.count(path) != 0) {
+    return;
+  }
+
+  vtkNew<vtkDICOMReader> reader;
+  reader->SetFileName(path.c_str());
+  reader->SetMemoryRowOrderToFileNative();
+  reader->Update();
+  vtkDICOMMetaData* meta = reader->GetMetaData();
+  if (reader->GetErrorCode() != 0 || !meta->Has(DicomTags::series_uid_tag)) {
+    std::cout << "Skip unreadable file " << path << std::endl;
+    return;
+  }
+  seen_files.insert(path);
+
+  // Срез собранного объёма - один кадр, многокадровые файлы не поддержаны
+  int dims[3];
+  reader->GetOutput()->GetDimensions(dims);
+  if (dims[2] != 1) {
+    std::cout << "Skip multi-frame file " << path << " (" << dims[2]
+              << " frames)" << std::endl;
+    return;
+  }
+
+  std::string uid = meta->Get(DicomTags::series_uid_tag).AsString();
+  if (series_uid.empty()) {
+    series_uid = uid;
+    vtkDICOMValue images = meta->Get(DicomTags::images_in_acquisition_tag);
+    if (expected_slices <= 0 && images.IsValid()) {
+      expected_slices = images.AsInt();
+    }
+  } else if (uid != series_uid) {
+    std::cout << "Skip slice of another series " << path << std::endl;
+    return;
+  }
+
+  // Положение среза - проекция его начала на нормаль к плоскости среза
+  Slice slice;
+  slice.image = reader->GetOutput();
+  slice.patient_matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  slice.patient_matrix->DeepCopy(reader->GetPatientMatrix());
+  slice.position = 0.0;
+  for (int i = 0; i != 3; ++i) {
+    slice.position += slice.patient_matrix->GetElement(i, 2) *
+                      slice.patient_matrix->GetElement(i, 3);
+  }
+  auto place = std::upper_bound(
+      slices.begin(), slices.end(), slice,
+      [](const Slice& a, const Slice& b) { return a.position < b.position; });
+  slices.insert(place, slice);
+}
+/*****************************************************************************/
+bool StreamingIngestor::isComplete() const {
+  return expected_slices > 0 &&
+         static_cast<int>(slices.size()) >= expected_slices;
+}
+/*****************************************************************************/
+void StreamingIngestor::assembleVolume() {
+  if (slices.empty()) {
+    throw std::runtime_error("No slices received in " + directory);
+  }
+  vtkImageData* first = slices.front().image;
+  int dims[3];
+  first->GetDimensions(dims);
+  double spacing[3];
+  first->GetSpacing(spacing);
+  if (slices.size() > 1) {
+    spacing[2] = (slices.back().position - slices.front().position) /
+                 static_cast<double>(slices.size() - 1);
+    checkSliceSpacing(spacing[2]);
+  }
+
+  image_data = vtkSmartPointer<vtkImageData>::New();
+  image_data->SetDimensions(dims[0], dims[1], static_cast<int>(slices.size()));
+  image_data->SetSpacing(spacing);
+  image_data->SetOrigin(0.0, 0.0, 0.0);
+  image_data->AllocateScalars(first->GetScalarType(),
+                              first->GetNumberOfScalarComponents());
+
+  std::size_t slice_size = static_cast<std::size_t>(dims[0]) * dims[1] *
+                           first->GetScalarSize() *
+                           first->GetNumberOfScalarComponents();
+  unsigned char* data =
+      static_cast<unsigned char*>(image_data->GetScalarPointer());
+  for (std::size_t i = 0; i != slices.size(); ++i) {
+    vtkImageData* image = slices[i].image;
+    int slice_dims[3];
+    image->GetDimensions(slice_dims);
+    if (slice_dims[0] != dims[0] || slice_dims[1] != dims[1] ||
+        image->GetScalarType() != first->GetScalarType()) {
+      throw std::runtime_error("Slices of different size in series");
+    }
+    std::memcpy(data + i * slice_size, image->GetScalarPointer(), slice_size);
+  }
+
+  // Матрица нижнего среза переводит индексы собранного объёма в
+  // координаты пациента
+  patient_matrix = slices.front().patient_matrix;
+  slices.clear();
+}
+/*****************************************************************************/
+void StreamingIngestor::checkSliceSpacing(double spacing) const {
+  // Пропущенный срез или повтор положения дают неверный шаг по z всему
+  // объёму, такая серия не собирается
+  const double tolerance = 0.01;
+  for (std::size_t i = 1; i != slices.size(); ++i) {
+    double delta = slices[i].position - slices[i - 1].position;
+    if (spacing <= 0.0 ||
+        std::abs(delta - spacing) > tolerance * spacing) {
+      throw std::runtime_error(
+          "Uneven slice positions in series: step " + std::to_string(delta) +
+          " mm between slices " + std::to_string(i - 1) + " and " +
+          std::to_string(i) + ", mean step " + std::to_string(spacing) +
+          " mm");
+    }
+  }
+}
+/*****************************************************************************/
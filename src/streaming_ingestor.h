@@ -0,0 +1,63 @@
+#ifndef STREAMING_INGESTOR
+#define STREAMING_INGESTOR
+
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+/*****************************************************************************/
+// С записью сканера совмещается только чтение и декодирование срезов.
+// Порог, сглаживание и поверхность по готовым слоям не строятся: сетка
+// объёма после поворота в координаты пациента и ресемплинга до 255
+// известна лишь по всей серии, а выбор наибольшей компоненты и выпуклая
+// оболочка требуют всей поверхности. Без известного числа срезов модель
+// начинает строиться не раньше settle_seconds после последнего среза
+class StreamingIngestor {
+ public:
+  // Приём заканчивается, когда пришло expected_slices_ срезов (при <= 0 -
+  // из ImagesInAcquisition) или после settle_seconds_ тишины в каталоге
+  StreamingIngestor(const std::string& directory_, int expected_slices_,
+                    double settle_seconds_);
+  ~StreamingIngestor();
+  StreamingIngestor(StreamingIngestor const&) = delete;
+  void operator=(StreamingIngestor const&) = delete;
+
+ public:
+  // Блокируется до записи последнего среза, декодируя срезы по мере
+  // их появления в каталоге
+  void run();
+  vtkSmartPointer<vtkImageData> getImageData();
+  vtkSmartPointer<vtkMatrix4x4> getPatientMatrix();
+  std::string getSeriesUid();
+
+ private:
+  void scanDirectory();
+  void readEvents();
+  void addFile(const std::string& path);
+  bool isComplete() const;
+  void assembleVolume();
+  void checkSliceSpacing(double spacing) const;
+
+ private:
+  struct Slice {
+    double position;
+    vtkSmartPointer<vtkImageData> image;
+    vtkSmartPointer<vtkMatrix4x4> patient_matrix;
+  };
+
+  std::string directory;
+  int expected_slices;
+  double settle_seconds;
+  int inotify_fd;
+  std::string series_uid;
+  std::set<std::string> seen_files;
+  std::vector<Slice> slices;
+  vtkSmartPointer<vtkImageData> image_data;
+  vtkSmartPointer<vtkMatrix4x4> patient_matrix;
+};
+/*****************************************************************************/
+#endif  // STREAMING_INGESTOR
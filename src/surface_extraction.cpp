@@ -0,0 +1,163 @@
+#include "surface_extraction.h"
+
+#include <vtkAppendPolyData.h>
+#include <vtkCleanPolyData.h>
+#include <vtkExtractVOI.h>
+#include <vtkFlyingEdges3D.h>
+#include <vtkPolyDataConnectivityFilter.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "mesh_smoother.h"
+#include "recursive_gaussian.h"
+#include "separable_gaussian.h"
+
+/*****************************************************************************/
+namespace {
+// Середина между 0 и 1024 маски
+const double mask_iso_value = 512;
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> extractLargestRegion(vtkPolyData* input) {
+  vtkNew<vtkPolyDataConnectivityFilter> confilter;
+  confilter->SetInputData(input);
+  confilter->SetExtractionModeToLargestRegion();
+  confilter->Update();
+  vtkSmartPointer<vtkPolyData> surface = confilter->GetOutput();
+  return surface;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkImageData> smoothMask(vtkImageData* mask,
+                                         const BrickMap& bricks,
+                                         const std::string& smoothing_mode,
+                                         double gauss_radius,
+                                         double gauss_deviation,
+                                         BufferPool* pool) {
+  auto start = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkImageData> smoothed;
+  if (smoothing_mode == "iir") {
+    RecursiveGaussian recursive_gauss(gauss_deviation);
+    smoothed = recursive_gauss.smooth(mask, bricks, pool);
+  } else {
+    SeparableGaussian gauss(gauss_deviation, gauss_radius);
+    smoothed = gauss.smooth(mask, bricks, pool);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << (smoothing_mode == "iir" ? "iir" : "fir")
+            << " smoothing: " << elapsed.count() << " ms" << std::endl;
+  return smoothed;
+}
+/*****************************************************************************/
+}  // namespace
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> extractBlockSurface(vtkImageData* volume,
+                                                 const BrickMap& bricks,
+                                                 double iso_value,
+                                                 bool normals) {
+  std::vector<std::array<int, 6>> blocks = bricks.getCrossingBlocks(iso_value);
+  if (blocks.empty()) {
+    return nullptr;
+  }
+  vtkNew<vtkAppendPolyData> append;
+  for (const std::array<int, 6>& block : blocks) {
+    vtkNew<vtkExtractVOI> voi;
+    voi->SetInputData(volume);
+    voi->SetVOI(block[0], block[1], block[2], block[3], block[4], block[5]);
+    voi->Update();
+
+    vtkNew<vtkFlyingEdges3D> flying_edges;
+    flying_edges->SetInputData(voi->GetOutput());
+    flying_edges->SetComputeNormals(normals);
+    flying_edges->ComputeScalarsOff();
+    flying_edges->SetValue(0, iso_value);
+    flying_edges->Update();
+    append->AddInputData(flying_edges->GetOutput());
+  }
+  append->Update();
+  std::cout << "surface blocks: " << blocks.size() << std::endl;
+
+  double spacing[3];
+  volume->GetSpacing(spacing);
+  vtkNew<vtkCleanPolyData> cleaner;
+  cleaner->SetInputData(append->GetOutput());
+  cleaner->ToleranceIsAbsoluteOn();
+  cleaner->SetAbsoluteTolerance(
+      1e-4 * std::min({spacing[0], spacing[1], spacing[2]}));
+  cleaner->Update();
+  vtkSmartPointer<vtkPolyData> surface = cleaner->GetOutput();
+  return surface;
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> extractVolumeSmoothedSurface(
+    vtkImageData* mask, const std::string& smoothing_mode, double gauss_radius,
+    double gauss_deviation, BufferPool* pool) {
+  // Сглаживание считается только в блоках в пределах ядра от непостоянных
+  // блоков маски, поверхность - только в блоках, чей диапазон пересекает
+  // изоуровень. Остальные блоки постоянны и поверхности не дают
+  BrickMap mask_bricks(mask);
+  if (mask_bricks.getNumberOfNonConstantBricks() == 0) {
+    std::cout << "Threshold mask is constant, no surface" << std::endl;
+    return nullptr;
+  }
+  std::cout << "active bricks: " << mask_bricks.getNumberOfNonConstantBricks()
+            << " / " << mask_bricks.getNumberOfBricks() << std::endl;
+
+  PooledImage smoothed(pool, smoothMask(mask, mask_bricks, smoothing_mode,
+                                        gauss_radius, gauss_deviation, pool));
+
+  // Диапазоны читаются только там, куда достало сглаживание
+  BrickMap smooth_bricks(
+      smoothed.get(), mask_bricks,
+      getSmoothingReach(smoothing_mode, gauss_radius, gauss_deviation));
+  vtkSmartPointer<vtkPolyData> blocks_surface =
+      extractBlockSurface(smoothed.get(), smooth_bricks, mask_iso_value, true);
+  if (!blocks_surface) {
+    std::cout << "Smoothed mask does not cross iso value" << std::endl;
+    return nullptr;
+  }
+  return extractLargestRegion(blocks_surface);
+}
+/*****************************************************************************/
+vtkSmartPointer<vtkPolyData> extractMeshSmoothedSurface(
+    vtkImageData* mask, double gauss_radius, double gauss_deviation) {
+  // Поверхность снимается прямо с бинарной маски и сглаживается уже как
+  // сетка: работа пропорциональна числу треугольников, а не вокселей
+  BrickMap mask_bricks(mask);
+  vtkSmartPointer<vtkPolyData> blocks_surface =
+      extractBlockSurface(mask, mask_bricks, mask_iso_value, false);
+  if (!blocks_surface) {
+    std::cout << "Threshold mask is constant, no surface" << std::endl;
+    return nullptr;
+  }
+  vtkSmartPointer<vtkPolyData> surface = extractLargestRegion(blocks_surface);
+
+  auto start = std::chrono::steady_clock::now();
+  MeshSmoother smoother =
+      MeshSmoother::fromGaussParameters(gauss_radius, gauss_deviation);
+  vtkSmartPointer<vtkPolyData> smoothed = smoother.smooth(surface);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "mesh smoothing: " << smoother.getIterations()
+            << " iterations, pass band " << smoother.getPassBand() << ", "
+            << elapsed.count() << " ms" << std::endl;
+
+  vtkNew<vtkCleanPolyData> cleaner;
+  cleaner->SetInputData(smoothed);
+  cleaner->Update();
+  vtkSmartPointer<vtkPolyData> result = cleaner->GetOutput();
+  return result;
+}
+/*****************************************************************************/
+int getSmoothingReach(const std::string& smoothing_mode, double gauss_radius,
+                      double gauss_deviation) {
+  // Рекурсивный фильтр обрезаем на 4 sigma
+  if (smoothing_mode == "iir") {
+    return RecursiveGaussian(gauss_deviation).getReach();
+  }
+  return SeparableGaussian(gauss_deviation, gauss_radius).getReach();
+}
+/*****************************************************************************/
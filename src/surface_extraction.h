@@ -0,0 +1,36 @@
+#ifndef SURFACE_EXTRACTION
+#define SURFACE_EXTRACTION
+
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+#include "brick_map.h"
+#include "buffer_pool.h"
+
+/*****************************************************************************/
+// Стадии построения поверхности по бинарной маске 0/1024. ModelBuilder и
+// тесты вызывают одни и те же функции
+/*****************************************************************************/
+// Изоповерхность по полосам блоков, чей диапазон пересекает iso_value.
+// Вершины на общих гранях соседних полос сливаются, nullptr - таких нет
+vtkSmartPointer<vtkPolyData> extractBlockSurface(vtkImageData* volume,
+                                                 const BrickMap& bricks,
+                                                 double iso_value,
+                                                 bool normals);
+// Режимы fir и iir: маска сглаживается гауссом только в блоках в пределах
+// ядра от её границы, затем наибольшая связная изоповерхность.
+// nullptr - маска постоянна
+vtkSmartPointer<vtkPolyData> extractVolumeSmoothedSurface(
+    vtkImageData* mask, const std::string& smoothing_mode, double gauss_radius,
+    double gauss_deviation, BufferPool* pool = nullptr);
+// Режим mesh: поверхность снимается с маски и сглаживается как сетка
+vtkSmartPointer<vtkPolyData> extractMeshSmoothedSurface(
+    vtkImageData* mask, double gauss_radius, double gauss_deviation);
+// Сколько вокселей от границы маски меняет объёмное сглаживание
+int getSmoothingReach(const std::string& smoothing_mode, double gauss_radius,
+                      double gauss_deviation);
+/*****************************************************************************/
+#endif  // SURFACE_EXTRACTION
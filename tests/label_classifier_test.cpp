@@ -0,0 +1,19 @@
+#include <catch2/catch.hpp>
+
+#include <string>
+
+#include "label_classifier.h"
+
+/*****************************************************************************/
+TEST_CASE("Label names are safe to use in model file names",
+          "[label_classifier]") {
+  CHECK(LabelClassifier::isValidName("bone"));
+  CHECK(LabelClassifier::isValidName("soft tissue.v2"));
+  CHECK_FALSE(LabelClassifier::isValidName(""));
+  CHECK_FALSE(LabelClassifier::isValidName("../bone"));
+  CHECK_FALSE(LabelClassifier::isValidName(".."));
+  CHECK_FALSE(LabelClassifier::isValidName("a/b"));
+  CHECK_FALSE(LabelClassifier::isValidName("a\\b"));
+  CHECK_FALSE(LabelClassifier::isValidName(std::string("a\0b", 3)));
+}
+/*****************************************************************************/
@@ -0,0 +1,89 @@
+#include <catch2/catch.hpp>
+
+#include <vtkImageData.h>
+#include <vtkImageGaussianSmooth.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "brick_map.h"
+#include "recursive_gaussian.h"
+#include "sphere_mask.h"
+
+/*****************************************************************************/
+TEST_CASE("Recursive gaussian matches vtkImageGaussianSmooth",
+          "[recursive_gaussian]") {
+  // Края объёма дальше радиуса ядра от шара, граничные режимы фильтров
+  // на результат не влияют
+  const double sigma = 2.0;
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(44, 8.0);
+
+  vtkSmartPointer<vtkImageData> recursive =
+      RecursiveGaussian(sigma).smooth(mask);
+
+  vtkNew<vtkImageGaussianSmooth> gauss;
+  gauss->SetInputData(mask);
+  gauss->SetDimensionality(3);
+  gauss->SetStandardDeviation(sigma);
+  gauss->SetRadiusFactor(5);
+  gauss->Update();
+  vtkImageData* reference = gauss->GetOutput();
+
+  REQUIRE(reference->GetScalarType() == VTK_FLOAT);
+  const float* iir = static_cast<const float*>(recursive->GetScalarPointer());
+  const float* fir = static_cast<const float*>(reference->GetScalarPointer());
+  vtkIdType count = mask->GetNumberOfPoints();
+  double max_error = 0;
+  double sum_error = 0;
+  for (vtkIdType i = 0; i != count; ++i) {
+    double error = std::abs(static_cast<double>(iir[i]) - fir[i]);
+    max_error = std::max(max_error, error);
+    sum_error += error;
+  }
+
+  // Приближение Янга - ван Флита: на этом шаре около 4.2% шкалы в худшем
+  // вокселе и 0.15% в среднем. Ошибка - свойство приближения, а не
+  // округления, запас в полтора раза оставлен под другие сборки VTK
+  CHECK(max_error < 0.065 * 1024);
+  CHECK(sum_error / count < 0.01 * 1024);
+}
+/*****************************************************************************/
+TEST_CASE("Recursive gaussian with small sigma keeps the input",
+          "[recursive_gaussian]") {
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(16, 4.0);
+  vtkSmartPointer<vtkImageData> smoothed = RecursiveGaussian(0.3).smooth(mask);
+
+  const float* input = static_cast<const float*>(mask->GetScalarPointer());
+  const float* output = static_cast<const float*>(smoothed->GetScalarPointer());
+  vtkIdType count = mask->GetNumberOfPoints();
+  CHECK(std::equal(input, input + count, output));
+}
+/*****************************************************************************/
+TEST_CASE("Recursive gaussian over active bricks matches the full pass",
+          "[recursive_gaussian]") {
+  // Шар смещён к углу куба 96^3: затронутые блоки по каждой оси - с 16
+  // по 63 воксель, полосы кончаются внутри строк, и хвост рекурсивного
+  // фильтра дальше 4 sigma за краем полосы обрезается
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(96, 8.0, 36.5);
+  BrickMap bricks(mask);
+  REQUIRE(bricks.getNumberOfNonConstantBricks() < bricks.getNumberOfBricks());
+
+  RecursiveGaussian recursive(2.0);
+  vtkSmartPointer<vtkImageData> full = recursive.smooth(mask);
+  vtkSmartPointer<vtkImageData> skipped = recursive.smooth(mask, bricks);
+
+  const float* expected = static_cast<const float*>(full->GetScalarPointer());
+  const float* output = static_cast<const float*>(skipped->GetScalarPointer());
+  double max_error = 0;
+  for (vtkIdType i = 0; i != mask->GetNumberOfPoints(); ++i) {
+    max_error = std::max(
+        max_error, std::abs(static_cast<double>(output[i]) - expected[i]));
+  }
+  // Обрезка действительно происходит (около 1e-3 на этом шаре), но много
+  // меньше отклонений, заметных для изоуровня 512
+  CHECK(max_error > 0);
+  CHECK(max_error < 0.001 * 1024);
+}
+/*****************************************************************************/
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+
+#include <vtkImageData.h>
+#include <vtkImageGaussianSmooth.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "brick_map.h"
+#include "separable_gaussian.h"
+#include "sphere_mask.h"
+
+/*****************************************************************************/
+TEST_CASE("Separable gaussian matches vtkImageGaussianSmooth",
+          "[separable_gaussian]") {
+  // Шар занимает малую часть объёма, большинство блоков пропускается
+  const double sigma = 2.0;
+  const double radius_factor = 5.0;
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(64, 8.0);
+  BrickMap bricks(mask);
+  REQUIRE(bricks.getNumberOfNonConstantBricks() < bricks.getNumberOfBricks());
+
+  vtkSmartPointer<vtkImageData> smoothed =
+      SeparableGaussian(sigma, radius_factor).smooth(mask, bricks);
+
+  vtkNew<vtkImageGaussianSmooth> gauss;
+  gauss->SetInputData(mask);
+  gauss->SetDimensionality(3);
+  gauss->SetStandardDeviation(sigma);
+  gauss->SetRadiusFactor(radius_factor);
+  gauss->Update();
+  vtkImageData* reference = gauss->GetOutput();
+
+  REQUIRE(reference->GetScalarType() == VTK_FLOAT);
+  const float* output = static_cast<const float*>(smoothed->GetScalarPointer());
+  const float* expected =
+      static_cast<const float*>(reference->GetScalarPointer());
+  double max_error = 0;
+  for (vtkIdType i = 0; i != mask->GetNumberOfPoints(); ++i) {
+    max_error = std::max(
+        max_error, std::abs(static_cast<double>(output[i]) - expected[i]));
+  }
+  // Та же свёртка, расхождение только в округлении float
+  CHECK(max_error < 0.01);
+}
+/*****************************************************************************/
+TEST_CASE("Brick map of the smoothed volume skips unreached bricks",
+          "[separable_gaussian]") {
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(64, 8.0);
+  BrickMap mask_bricks(mask);
+  SeparableGaussian gauss(2.0, 5.0);
+  vtkSmartPointer<vtkImageData> smoothed = gauss.smooth(mask, mask_bricks);
+
+  BrickMap full(smoothed);
+  BrickMap reached(smoothed, mask_bricks, gauss.getReach());
+  REQUIRE(full.getNumberOfBricks() == reached.getNumberOfBricks());
+  for (int brick = 0; brick != full.getNumberOfBricks(); ++brick) {
+    CHECK(full.isConstant(brick) == reached.isConstant(brick));
+    CHECK(full.getBrickMin(brick) == reached.getBrickMin(brick));
+  }
+  CHECK(full.getCrossingBlocks(512) == reached.getCrossingBlocks(512));
+}
+/*****************************************************************************/
@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+
+#include <vtkHausdorffDistancePointSetFilter.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "sphere_mask.h"
+#include "surface_extraction.h"
+
+/*****************************************************************************/
+namespace {
+// Параметры сглаживания по умолчанию из BuildOptions
+const double gauss_radius = 5;
+const double gauss_deviation = 2;
+const int size = 48;
+const double radius = 16;
+
+// Стадии ModelBuilder до выпуклой оболочки: после неё режимы почти не
+// различаются, сравнивать надо поверхности до неё
+vtkSmartPointer<vtkPolyData> extractTimed(vtkImageData* mask,
+                                          const std::string& mode) {
+  auto start = std::chrono::steady_clock::now();
+  vtkSmartPointer<vtkPolyData> surface =
+      mode == "mesh"
+          ? extractMeshSmoothedSurface(mask, gauss_radius, gauss_deviation)
+          : extractVolumeSmoothedSurface(mask, mode, gauss_radius,
+                                         gauss_deviation);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << mode << " surface: " << elapsed.count() << " ms" << std::endl;
+  return surface;
+}
+
+double hausdorffDistance(vtkPolyData* a, vtkPolyData* b) {
+  vtkNew<vtkHausdorffDistancePointSetFilter> hausdorff;
+  hausdorff->SetInputData(0, a);
+  hausdorff->SetInputData(1, b);
+  hausdorff->SetTargetDistanceMethodToPointToCell();
+  hausdorff->Update();
+  return hausdorff->GetHausdorffDistance();
+}
+
+// Наибольшее и среднее отклонение вершин от радиуса шара
+void radialError(vtkPolyData* surface, double* max_error,
+                 double* mean_error) {
+  double center = (size - 1) / 2.0;
+  *max_error = 0;
+  double sum = 0;
+  vtkIdType count = surface->GetNumberOfPoints();
+  for (vtkIdType i = 0; i != count; ++i) {
+    double point[3];
+    surface->GetPoint(i, point);
+    double dx = point[0] - center;
+    double dy = point[1] - center;
+    double dz = point[2] - center;
+    double error = std::sqrt(dx * dx + dy * dy + dz * dz) - radius;
+    *max_error = std::max(*max_error, std::abs(error));
+    sum += error;
+  }
+  *mean_error = count ? sum / count : 0;
+}
+}  // namespace
+/*****************************************************************************/
+TEST_CASE("Smoothing modes give close surfaces before the hull",
+          "[mesh_smoother][benchmark]") {
+  // Воспроизводимый вариант benchmark_smoothing: шар радиуса 16 в кубе 48^3.
+  // Время печатается для сравнения, проверяется только геометрия
+  vtkSmartPointer<vtkImageData> mask = makeSphereMask(size, radius);
+
+  vtkSmartPointer<vtkPolyData> fir_surface = extractTimed(mask, "fir");
+  vtkSmartPointer<vtkPolyData> iir_surface = extractTimed(mask, "iir");
+  vtkSmartPointer<vtkPolyData> mesh_surface = extractTimed(mask, "mesh");
+  REQUIRE(fir_surface.Get() != nullptr);
+  REQUIRE(iir_surface.Get() != nullptr);
+  REQUIRE(mesh_surface.Get() != nullptr);
+
+  // Гаусс с sigma 2 сдвигает изоповерхность шара внутрь на sigma^2 / R,
+  // точно - на 0.25 вокселя. Рекурсивный фильтр приближает тот же гаусс.
+  // Ступеньки маски до сглаживания сетки дают не больше половины вокселя,
+  // сглаживание Таубина шар почти не сжимает
+  for (vtkPolyData* surface : {fir_surface.Get(), iir_surface.Get()}) {
+    double max_error = 0;
+    double mean_error = 0;
+    radialError(surface, &max_error, &mean_error);
+    CHECK(mean_error == Approx(-0.25).margin(0.15));
+    CHECK(max_error < 0.6);
+  }
+
+  double mesh_max = 0;
+  double mesh_mean = 0;
+  radialError(mesh_surface, &mesh_max, &mesh_mean);
+  CHECK(std::abs(mesh_mean) < 0.25);
+  CHECK(mesh_max < 0.75);
+
+  double iir_distance = hausdorffDistance(iir_surface, fir_surface);
+  double mesh_distance = hausdorffDistance(mesh_surface, fir_surface);
+  std::cout << "hausdorff distance to fir: iir " << iir_distance << ", mesh "
+            << mesh_distance << std::endl;
+  CHECK(iir_distance < 0.5);
+  CHECK(mesh_distance < 1.0);
+}
+/*****************************************************************************/
@@ -0,0 +1,35 @@
+#ifndef SPHERE_MASK
+#define SPHERE_MASK
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+/*****************************************************************************/
+// Бинарная маска-шар 0/1024 с центром в (center, center, center), как после
+// порога в ModelBuilder
+inline vtkSmartPointer<vtkImageData> makeSphereMask(int size, double radius,
+                                                    double center) {
+  vtkSmartPointer<vtkImageData> mask = vtkSmartPointer<vtkImageData>::New();
+  mask->SetDimensions(size, size, size);
+  mask->AllocateScalars(VTK_FLOAT, 1);
+  float* data = static_cast<float*>(mask->GetScalarPointer());
+  for (int z = 0; z != size; ++z) {
+    for (int y = 0; y != size; ++y) {
+      for (int x = 0; x != size; ++x) {
+        double dx = x - center;
+        double dy = y - center;
+        double dz = z - center;
+        bool inside = dx * dx + dy * dy + dz * dz <= radius * radius;
+        *data++ = inside ? 1024.0f : 0.0f;
+      }
+    }
+  }
+  return mask;
+}
+/*****************************************************************************/
+// Шар в центре куба
+inline vtkSmartPointer<vtkImageData> makeSphereMask(int size, double radius) {
+  return makeSphereMask(size, radius, (size - 1) / 2.0);
+}
+/*****************************************************************************/
+#endif  // SPHERE_MASK